@@ -49,6 +49,7 @@ my @cases = qw(
   GridFSDownloadOne
 
   JSONMultiImport
+  JSONMultiImportPipelined
   JSONMultiExport
   GridFSMultiImport
   GridFSMultiExport
@@ -36,7 +36,6 @@ sub parallel_mongodb {
     for my $i ( 0 .. $jobs - 1 ) {
         $pm->start and next;
         $SIG{INT} = sub { $pm->finish };
-        $context->{mc}->reconnect;
         $fcn->( $context, $jobs, $i );
         $pm->finish;
     }
@@ -88,6 +87,27 @@ sub do_task {
 
 }
 
+package JSONMultiImportPipelined;
+
+# like JSONMultiImport, but from a single process with encoding workers
+
+our @ISA = qw/BenchParallel/;
+
+sub setup { JSONMultiImport::setup(@_) }
+
+sub before_task { JSONMultiImport::before_task(@_) }
+
+sub do_task {
+    my $context = shift;
+    my ( $coll, $json ) = @{$context}{qw/coll json/};
+
+    my $bulk = $coll->unordered_bulk( { encodeWorkers => 4 } );
+    for my $f ( sort grep { /\.txt$/ } $context->{doc_dir}->children ) {
+        $bulk->insert_one( $json->decode($_) ) for $f->lines_utf8;
+    }
+    $bulk->execute;
+}
+
 package JSONMultiExport;
 
 our @ISA = qw/BenchParallel/;
@@ -0,0 +1,389 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::BufferedCollection;
+
+# ABSTRACT: Collects single-document writes and sends them as bulk writes
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use Safe::Isa;
+use Time::HiRes qw/time/;
+use MongoDB::Error;
+use MongoDB::_Constants;
+use MongoDB::_Types qw(
+    Boolish
+    MongoDBCollection
+    NonNegNum
+);
+use Types::Standard qw(
+    ArrayRef
+);
+
+use namespace::clean -except => 'meta';
+
+=attr collection (required)
+
+The L<MongoDB::Collection> the writes are sent to.
+
+=cut
+
+has collection => (
+    is       => 'ro',
+    isa      => MongoDBCollection,
+    required => 1,
+);
+
+=attr ordered
+
+Whether each flush is an ordered bulk write.  Defaults to false, which lets
+writes of a type be grouped together.
+
+=cut
+
+has ordered => (
+    is      => 'ro',
+    isa     => Boolish,
+    default => 0,
+);
+
+=attr max_ops
+
+The number of queued writes that triggers a flush.  Defaults to 1000, the
+server's write batch size.
+
+=cut
+
+has max_ops => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => MAX_WRITE_BATCH_SIZE,
+);
+
+=attr max_bytes
+
+The encoded size of the queued writes that triggers a flush.  Defaults to
+16MiB.
+
+=cut
+
+has max_bytes => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => 16_777_216,
+);
+
+=attr max_delay_ms
+
+The time in milliseconds after which a queued write is flushed by the next
+write, or by L</flush_due>.  Defaults to 100.  Zero disables the time
+threshold.
+
+=cut
+
+has max_delay_ms => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => 100,
+);
+
+=attr bson_codec
+
+The codec of the collection, used to encode queued writes.
+
+=cut
+
+has bson_codec => (
+    is       => 'lazy',
+    init_arg => undef,
+    builder  => sub { $_[0]->collection->bson_codec },
+);
+
+with 'MongoDB::Role::_InsertPreEncoder';
+
+# [ method, args, callback ] for each queued write
+has _queue => (
+    is       => 'ro',
+    isa      => ArrayRef,
+    init_arg => undef,
+    default  => sub { [] },
+);
+
+has _bytes => (
+    is       => 'rw',
+    isa      => NonNegNum,
+    init_arg => undef,
+    default  => 0,
+);
+
+# when the oldest queued write was added
+has _since => (
+    is       => 'rw',
+    init_arg => undef,
+);
+
+=method insert_one
+
+=method replace_one
+
+=method update_one
+
+=method update_many
+
+=method delete_one
+
+=method delete_many
+
+    $buffer->insert_one( $doc );
+    $buffer->insert_one( $doc, sub { my ( $error, $id ) = @_; ... } );
+    $buffer->insert_one( $doc, $options, $callback );
+    $buffer->update_one( $filter, $update, $options, $callback );
+    $buffer->delete_one( $filter, $options, $callback );
+
+These take the same arguments as the L<MongoDB::Collection> methods of the
+same name, plus an optional code reference, and queue the write instead of
+sending it.  A write that fills the buffer flushes it, so any of these may
+throw the errors of L</flush>.
+
+The code reference is called when the write has been sent.  Its first
+argument is undef if the write succeeded.  Otherwise it is the write error
+document (see L<MongoDB::BulkWriteResult/write_errors>) for this write, or
+the exception if the bulk write failed as a whole.  For inserts and
+upserts the second argument is the C<_id> of the document.
+
+Documents to insert are encoded when they are queued, after an C<_id> is
+added to those without one.  The options of C<insert_one> apply to a whole
+bulk write, so any given to it must be empty; writes that need them should
+use L<MongoDB::Collection/bulk_write> instead.
+
+=cut
+
+sub insert_one {
+    my ( $self, $doc, @rest ) = @_;
+    my $cb = ref $rest[-1] eq 'CODE' ? pop @rest : undef;
+    my ($options) = @rest;
+
+    MongoDB::UsageError->throw("insert_one requires a single document reference as an argument")
+      unless ref $doc;
+
+    # the insert goes out in a bulk write, which has no options per insert
+    MongoDB::UsageError->throw("insert_one options are not supported by MongoDB::BufferedCollection")
+      if defined $options && ( ref $options ne 'HASH' || %$options );
+
+    # encoded the way MongoDB::Op::_BulkWrite would, which then sends the
+    # bytes as they are; the server checks its own document size limit
+    my $raw = $self->_pre_encode_insert( 16_777_216, $doc, '.' );
+    return $self->_add( insert_one => [$raw], $cb, length $raw->{bson} );
+}
+
+sub replace_one { my $self = shift; $self->_add_update( replace_one => @_ ) }
+sub update_one  { my $self = shift; $self->_add_update( update_one  => @_ ) }
+sub update_many { my $self = shift; $self->_add_update( update_many => @_ ) }
+sub delete_one  { my $self = shift; $self->_add_delete( delete_one  => @_ ) }
+sub delete_many { my $self = shift; $self->_add_delete( delete_many => @_ ) }
+
+sub _add_update {
+    my ( $self, $method, $filter, $update, @rest ) = @_;
+    my $cb = ref $rest[-1] eq 'CODE' ? pop @rest : undef;
+    my $codec = $self->bson_codec;
+    my $bytes = length( $codec->encode_one($filter) ) + length( $codec->encode_one($update) );
+    return $self->_add( $method => [ $filter, $update, @rest ], $cb, $bytes );
+}
+
+sub _add_delete {
+    my ( $self, $method, $filter, @rest ) = @_;
+    my $cb = ref $rest[-1] eq 'CODE' ? pop @rest : undef;
+    my $bytes = length $self->bson_codec->encode_one($filter);
+    return $self->_add( $method => [ $filter, @rest ], $cb, $bytes );
+}
+
+sub _add {
+    my ( $self, $method, $args, $cb, $bytes ) = @_;
+    my $queue = $self->_queue;
+
+    $self->_since(time) unless @$queue;
+    push @$queue, [ $method, $args, $cb ];
+    $self->_bytes( $self->_bytes + $bytes );
+
+    $self->flush
+      if @$queue >= $self->max_ops
+      || $self->_bytes >= $self->max_bytes
+      || $self->_is_due;
+
+    return;
+}
+
+sub _is_due {
+    my ($self) = @_;
+    return 0 unless @{ $self->_queue } && $self->max_delay_ms;
+    return time - $self->_since >= $self->max_delay_ms / 1000;
+}
+
+=method pending
+
+    $count = $buffer->pending;
+
+Returns the number of queued writes.
+
+=cut
+
+sub pending { scalar @{ $_[0]->_queue } }
+
+=method flush_due
+
+    $buffer->flush_due;
+
+Flushes the buffer if its oldest write has waited longer than
+L</max_delay_ms>.  Applications that may stop writing for a while can call
+this from a timer or their main loop.
+
+=cut
+
+sub flush_due {
+    my ($self) = @_;
+    return $self->_is_due ? $self->flush : undef;
+}
+
+=method flush
+
+    $result = $buffer->flush;
+
+Sends the queued writes as one bulk write, calls their code references and
+returns the L<MongoDB::BulkWriteResult>, or undef if nothing was queued.
+
+If the bulk write fails, the error is thrown after the code references have
+been called, unless every failed write had a code reference to report it
+to.  As with L<MongoDB::Collection/bulk_write>, a L<MongoDB::WriteError> or
+L<MongoDB::WriteConcernError> carries the result of the writes that were
+sent.
+
+=cut
+
+sub flush {
+    my ($self) = @_;
+    my $queue = $self->_queue;
+    return unless @$queue;
+
+    my @writes = splice @$queue;
+    $self->_bytes(0);
+
+    my ( $result, $error );
+    eval {
+        $result = $self->collection->bulk_write(
+            [ map { $_->[0] => $_->[1] } @writes ],
+            { ordered => $self->ordered },
+        );
+        1;
+    } or do {
+        $error = $@ || "unknown error";
+        $result = $error->$_can('result') ? $error->result : undef;
+        $result = undef unless $result->$_isa('MongoDB::BulkWriteResult');
+    };
+
+    my $unreported = $self->_report( \@writes, $result, $error );
+    die $error if $unreported;
+
+    return $result;
+}
+
+# Calls each write's code reference and returns true if an error was left
+# without one.  A write gets its own write error, if any.  A write concern
+# error, or an error without a result, applies to every write; so does a
+# write error of an ordered bulk write to the writes it kept from being sent.
+sub _report {
+    my ( $self, $writes, $result, $error ) = @_;
+
+    my ( %write_errors, %ids );
+    if ($result) {
+        $write_errors{ $_->{index} } = $_ for @{ $result->write_errors };
+        %ids = ( %{ $result->inserted_ids }, %{ $result->upserted_ids } );
+    }
+
+    # writes from this index on get $error
+    my $error_from = @$writes;
+    if ( $error && ( !$result || $error->$_isa('MongoDB::WriteConcernError') ) ) {
+        $error_from = 0;
+    }
+    elsif ( $error && $self->ordered && %write_errors ) {
+        ($error_from) = sort { $a <=> $b } keys %write_errors;
+        $error_from++;
+    }
+
+    my $unreported = 0;
+    for my $i ( 0 .. $#$writes ) {
+        my $err = $write_errors{$i} || ( $i >= $error_from ? $error : undef );
+        if ( my $cb = $writes->[$i][2] ) {
+            $cb->( $err, $ids{$i} );
+        }
+        elsif ($err) {
+            $unreported = 1;
+        }
+    }
+
+    return $unreported;
+}
+
+sub DEMOLISH {
+    my ( $self, $in_global_destruction ) = @_;
+    return if $in_global_destruction || !@{ $self->_queue };
+    eval { $self->flush; 1 } or warn "flushing buffered writes failed: $@";
+    return;
+}
+
+1;
+
+__END__
+
+=head1 SYNOPSIS
+
+    my $buffer = $coll->buffered( { max_delay_ms => 50 } );
+
+    for my $event (@events) {
+        $buffer->insert_one( $event );
+        $buffer->update_one(
+            { _id => $event->{user} },
+            { '$inc' => { events => 1 } },
+            { upsert => 1 },
+            sub {
+                my ( $error, $id ) = @_;
+                warn "count not updated: " . ( $error->{errmsg} // $error ) if $error;
+            }
+        );
+    }
+
+    $buffer->flush;
+
+=head1 DESCRIPTION
+
+This class queues single-document writes to a collection and sends them
+together as one L<bulk write|MongoDB::Collection/bulk_write> once enough
+writes, bytes or time have accumulated, or when L</flush> is called.  An
+application making many small writes then pays one round trip per batch
+instead of one per write.  It is returned by
+L<MongoDB::Collection/buffered>.
+
+Queued writes are not sent until the buffer is flushed.  Reads from the
+collection in the meantime don't see them, and they are lost if the program
+exits first.  A buffer that goes out of scope flushes itself, but errors
+from that flush can only be reported by the writes' code references or as
+warnings; call L</flush> before dropping a buffer whose writes matter.
+
+Without an event loop, the time threshold is checked only when a write is
+queued or L</flush_due> is called.
+
+=cut
@@ -29,6 +29,7 @@ use MongoDB::BulkWriteView;
 use Moo;
 use MongoDB::_Types qw(
     Boolish
+    NonNegNum
     to_WriteConcern
 );
 use Types::Standard qw(
@@ -74,6 +75,49 @@ has 'bypassDocumentValidation' => (
     isa      => Boolish,
 );
 
+=attr summaryOnly
+
+A boolean for whether the result should keep only counts and the first
+C<maxErrors> errors, instead of the C<_id> of every inserted or upserted
+document and every error along with its operation.  This keeps the memory
+used by the result of a very large bulk write flat.  Default is false.
+
+=cut
+
+has 'summaryOnly' => (
+    is       => 'ro',
+    isa      => Boolish,
+);
+
+=attr maxErrors
+
+With C<summaryOnly>, the number of write errors and write concern errors
+kept in the result.  Default is 100; at least one is always kept.
+
+=cut
+
+has 'maxErrors' => (
+    is       => 'ro',
+    isa      => NonNegNum,
+    default  => 100,
+);
+
+=attr encodeWorkers
+
+The number of processes to fork for encoding the documents to insert,
+while this process sends the documents already encoded.  Default is 0,
+which encodes every document in this process.  Workers are only started
+when there are more than 1000 documents to insert, and need a platform with
+a real C<fork>.
+
+=cut
+
+has 'encodeWorkers' => (
+    is       => 'ro',
+    isa      => NonNegNum,
+    default  => 0,
+);
+
 has '_executed' => (
     is       => 'rw',
     isa      => Boolish,
@@ -279,6 +323,8 @@ sub execute {
         queue                    => $self->_queue,
         ordered                  => $self->ordered,
         bypassDocumentValidation => $self->bypassDocumentValidation,
+        max_errors               => $self->summaryOnly ? $self->maxErrors : undef,
+        encodeWorkers            => $self->encodeWorkers,
         bson_codec               => $self->collection->bson_codec,
         write_concern            => $write_concern,
         session                  => $session,
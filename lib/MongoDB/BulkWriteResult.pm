@@ -103,6 +103,20 @@ sub has_modified_count {
     return defined( $self->modified_count );
 }
 
+# Set for a summary-only result: the number of write errors and write
+# concern errors to keep.  Inserted and upserted IDs are not kept at all.
+has _max_errors => (
+    is  => 'ro',
+    isa => (Numish|Undef),
+);
+
+# totals for a summary-only result, which may have dropped some errors
+has [qw/_write_error_total _write_concern_error_total/] => (
+    is      => 'rw',
+    isa     => Numish,
+    default => 0,
+);
+
 has op_count => (
     is       => 'ro',
     writer   => '_set_op_count',
@@ -117,6 +131,22 @@ has batch_count => (
     isa      => Numish,
 );
 
+sub is_summary { defined $_[0]->{_max_errors} }
+
+sub count_write_errors {
+    my ($self) = @_;
+    return defined $self->{_max_errors}
+      ? $self->{_write_error_total}
+      : scalar @{ $self->write_errors };
+}
+
+sub count_write_concern_errors {
+    my ($self) = @_;
+    return defined $self->{_max_errors}
+      ? $self->{_write_concern_error_total}
+      : scalar @{ $self->write_concern_errors };
+}
+
 #--------------------------------------------------------------------------#
 # emulate old API
 #--------------------------------------------------------------------------#
@@ -313,13 +343,18 @@ sub _merge_result {
         $self->_set_modified_count(undef);
     }
 
-    # Append error and upsert docs, index is dealt with in _parse_cmd_result
-    for my $attr (qw/write_errors upserted inserted/) {
-        push @{ $self->$attr }, @{ $result->$attr };
+    if ( defined( my $max = $self->_max_errors ) ) {
+        $self->_merge_summary( $result, $max );
     }
+    else {
+        # Append error and upsert docs, index is dealt with in _parse_cmd_result
+        for my $attr (qw/write_errors upserted inserted/) {
+            push @{ $self->$attr }, @{ $result->$attr };
+        }
 
-    # Append write concern errors without modification (they have no index)
-    push @{ $self->write_concern_errors }, @{ $result->write_concern_errors };
+        # Append write concern errors without modification (they have no index)
+        push @{ $self->write_concern_errors }, @{ $result->write_concern_errors };
+    }
 
     $self->_set_op_count( $self->op_count + $result->op_count );
     $self->_set_batch_count( $self->batch_count + $result->batch_count );
@@ -327,6 +362,30 @@ sub _merge_result {
     return 1;
 }
 
+# Keeps the first $max errors of each kind, without the operations that
+# caused them, and only counts the rest
+sub _merge_summary {
+    my ( $self, $result, $max ) = @_;
+
+    for my $pair (
+        [ write_errors         => '_write_error_total' ],
+        [ write_concern_errors => '_write_concern_error_total' ],
+      )
+    {
+        my ( $kind, $total ) = @$pair;
+        my ( $mine, $theirs ) = ( $self->$kind, $result->$kind );
+        $self->$total( $self->$total + @$theirs );
+        for my $error (@$theirs) {
+            last if @$mine >= $max;
+            my %copy = %$error;
+            delete $copy{op};
+            push @$mine, \%copy;
+        }
+    }
+
+    return;
+}
+
 1;
 
 __END__
@@ -432,6 +491,14 @@ The number of operations sent to the database.
 The number of database commands issued to the server.  This will be less
 than the C<op_count> if multiple operations were grouped together.
 
+=method is_summary
+
+True if the bulk write was executed with the C<summaryOnly> option.  A
+summary result has empty C<inserted> and C<upserted> lists, keeps at most
+C<maxErrors> write errors and write concern errors, and leaves out the C<op>
+field of write errors.  Its counts, including C<count_write_errors>, cover
+all operations.
+
 =method assert
 
 Throws an error if write errors or write concern errors occurred.
@@ -448,7 +515,8 @@ non-zero; otherwise returns 1.
 
 =method count_write_errors
 
-Returns the number of write errors
+Returns the number of write errors.  For a summary result, this may be more
+than the number of errors in C<write_errors>.
 
 =method count_write_concern_errors
 
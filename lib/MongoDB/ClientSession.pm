@@ -553,8 +553,9 @@ sub _maybe_unpin_address {
     $session->end_session;
 
 Close this particular session and release the session ID for reuse or
-recycling.  If a transaction is in progress, it will be aborted.  Has no
-effect after calling for the first time.
+recycling.  If a transaction is in progress, it will be aborted.  Cursors
+of the session that are still waiting to be killed are killed first.  Has
+no effect after calling for the first time.
 
 This will be called automatically by the object destructor.
 
@@ -562,12 +563,18 @@ This will be called automatically by the object destructor.
 
 sub end_session {
     my ( $self ) = @_;
+    $self->_end_session(1);
+}
+
+sub _end_session {
+    my ( $self, $send_kills ) = @_;
 
     if ( $self->_in_transaction_state ( TXN_IN_PROGRESS ) ) {
         # Ignore all errors
         eval { $self->abort_transaction };
     }
     if ( defined $self->_server_session ) {
+        $self->client->_send_session_kills($self) if $send_kills;
         $self->client->_server_session_pool->retire_server_session( $self->_server_session );
         $self->__clear_server_session;
     }
@@ -709,8 +716,9 @@ sub with_transaction {
 
 sub DEMOLISH {
     my ( $self, $in_global_destruction ) = @_;
-    # Implicit end of session in scope
-    $self->end_session;
+    # Implicit end of session in scope; at exit, the server times out any
+    # cursors still waiting to be killed
+    $self->_end_session( !$in_global_destruction );
 }
 
 1;
@@ -22,10 +22,12 @@ package MongoDB::Collection;
 use version;
 our $VERSION = 'v2.2.3';
 
+use MongoDB::BufferedCollection;
 use MongoDB::ChangeStream;
 use MongoDB::Error;
 use MongoDB::IndexView;
 use MongoDB::InsertManyResult;
+use MongoDB::PartitionedReader;
 use MongoDB::QueryResult;
 use MongoDB::WriteConcern;
 use MongoDB::Op::_Aggregate;
@@ -406,6 +408,9 @@ Valid options include:
   error (if any).  When false, all documents will be processed and any
   error will only be thrown after all insertions are attempted.  The
   default is true.
+* C<encodeWorkers> - the number of processes to fork for encoding the
+  documents while earlier batches are sent.  See
+  L<MongoDB::BulkWrite/encodeWorkers>.
 
 On MongoDB servers before version 2.6, C<insert_many> bulk operations are
 emulated with individual inserts to capture error information.  On 2.6 or
@@ -699,9 +704,19 @@ Valid options include:
 * C<cursorType> – indicates the type of cursor to use. It must be one of three
   string values: C<'non_tailable'> (the default), C<'tailable'>, and
   C<'tailable_await'>.
+* C<exhaust> – if true, the server streams the remaining batches of the
+  cursor after the first getMore without waiting for a request for each.
+  The connection is held by the cursor until the last batch is read, and is
+  closed if the cursor is abandoned before then.  This is a driver option and
+  is not sent to the server; servers before version 4.2 return one batch per
+  getMore as usual.
 * C<hint> – L<specify an index to
   use|http://docs.mongodb.org/manual/reference/command/count/#specify-the-index-to-use>;
   must be a string, array reference, hash reference or L<Tie::IxHash> object.
+* C<lazyDocuments> – if true, documents are returned as L<MongoDB::LazyDocument>
+  objects that keep the BSON received from the server and decode fields only
+  when they are accessed.  This is a driver option and is not sent to the
+  server.
 * C<limit> – the maximum number of documents to return.
 * C<max> – L<specify the B<exclusive> upper bound for a specific index|
   https://docs.mongodb.com/manual/reference/operator/meta/max/>.
@@ -709,6 +724,12 @@ Valid options include:
   new documents to satisfy a tailable cursor query. This only applies
   to a C<cursorType> of 'tailable_await'; the option is otherwise ignored.
   (Note, this will be ignored for servers before version 3.2.)
+* C<maxBatchBytes> – with C<targetBatchBytes>, a cap on the size of any batch
+  requested.  It is checked against the largest average document size of any
+  batch so far, not the overall average, so a run of larger documents shrinks
+  the following requests.  A single document much larger than the others in
+  its batch can still push a reply past the cap.  This is a driver option and
+  is not sent to the server.
 * C<maxScan> – (DEPRECATED) L<maximum number of documents or index keys to scan|
   https://docs.mongodb.com/manual/reference/operator/meta/maxScan/>.
 * C<maxTimeMS> – the maximum amount of time to allow the query to run.
@@ -724,6 +745,11 @@ Valid options include:
   newer server versions.
 * C<noCursorTimeout> – if true, prevents the server from timing out a cursor
   after a period of inactivity.
+* C<prefetch> – a number of documents; once no more than this many are left
+  to iterate in the current batch, the request for the next batch is sent so
+  that it is in transit while the rest are processed.  The connection is held
+  by the cursor until the batch is collected.  This is a driver option and is
+  not sent to the server; it has no effect on servers before version 3.2.
 * C<projection> - a hash reference defining fields to return. See "L<limit
   fields to return|http://docs.mongodb.org/manual/tutorial/project-fields-from-query-results/>"
   in the MongoDB documentation for details.
@@ -739,6 +765,11 @@ Valid options include:
   to return matching documents.  See the L<$orderby
   documentation|https://docs.mongodb.com/manual/reference/operator/meta/orderby/>
   for examples.
+* C<targetBatchBytes> – a size in bytes; each additional batch is requested
+  with a C<batchSize> chosen to make the reply about this large, based on the
+  size of the documents received so far.  For example, 4_000_000.  This is a
+  driver option and is not sent to the server; it takes precedence over
+  C<batchSize> after the first batch.
 
 For more information, see the L<Read Operations
 Overview|http://docs.mongodb.org/manual/core/read-operations-introduction/> in
@@ -1133,6 +1164,59 @@ sub watch {
     );
 }
 
+=method partitioned_reader
+
+    $reader = $coll->partitioned_reader( $filter );
+    $reader = $coll->partitioned_reader( $filter, $options );
+
+    while ( my @batch = $reader->next_batch ) {
+        ...
+    }
+
+Returns a L<MongoDB::PartitionedReader>, which splits the documents matching
+the filter into ranges of a key and reads the ranges in parallel, either
+over a connection each in this process or in forked worker processes.  The
+range boundaries come from a random sample of the key.
+
+The optional second argument is a hash reference with options:
+
+=for :list
+* C<key> - the field to partition on.  Defaults to C<_id>.  It should be
+  indexed; for a sharded collection, the shard key is a good choice.
+* C<partitions> - the number of ranges.  Defaults to 4.
+* C<sampleSize> - the number of documents sampled to find the range
+  boundaries.  Defaults to 100 per partition.
+* C<workers> - the number of processes forked by
+  L<MongoDB::PartitionedReader/each_partition>.  Defaults to 0, which reads
+  the partitions in this process.
+
+Any other options are passed to L</find> for each range.
+
+=cut
+
+sub partitioned_reader {
+    my ( $self, $filter, $options ) = @_;
+    my %find_options = $options ? %$options : ();
+
+    return MongoDB::PartitionedReader->new(
+        collection   => $self,
+        filter       => $filter || {},
+        exists($find_options{key})
+            ? (key => delete $find_options{key})
+            : (),
+        exists($find_options{partitions})
+            ? (partitions => delete $find_options{partitions})
+            : (),
+        exists($find_options{sampleSize})
+            ? (sample_size => delete $find_options{sampleSize})
+            : (),
+        exists($find_options{workers})
+            ? (workers => delete $find_options{workers})
+            : (),
+        find_options => \%find_options,
+    );
+}
+
 =method aggregate
 
     @pipeline = (
@@ -1495,6 +1579,8 @@ Valid options include:
 =for :list
 * C<bypassDocumentValidation> - skips document validation, if enabled; this
   is ignored for MongoDB servers older than version 3.2.
+* C<summaryOnly> and C<maxErrors> - see L<MongoDB::BulkWrite/summaryOnly>.
+* C<encodeWorkers> - see L<MongoDB::BulkWrite/encodeWorkers>.
 
 =cut
 
@@ -1519,6 +1605,8 @@ Valid options include:
 =for :list
 * C<bypassDocumentValidation> - skips document validation, if enabled; this
   is ignored for MongoDB servers older than version 3.2.
+* C<summaryOnly> and C<maxErrors> - see L<MongoDB::BulkWrite/summaryOnly>.
+* C<encodeWorkers> - see L<MongoDB::BulkWrite/encodeWorkers>.
 
 =cut
 
@@ -1528,6 +1616,42 @@ sub initialize_unordered_bulk_op {
     return MongoDB::BulkWrite->new( %$args, collection => $self, ordered => 0 );
 }
 
+=method buffered
+
+    $buffer = $coll->buffered;
+    $buffer = $coll->buffered( { max_ops => 500, max_delay_ms => 20 } );
+
+    $buffer->insert_one( $doc );
+    $buffer->flush;
+
+Returns a L<MongoDB::BufferedCollection>, which queues calls to
+C<insert_one>, C<replace_one>, C<update_one>, C<update_many>, C<delete_one>
+and C<delete_many> and sends them to this collection as bulk writes.
+
+A hash reference of options may be provided.
+
+Valid options include:
+
+=for :list
+* C<ordered> - when true, each flush is an ordered bulk write.  The default
+  is false.
+* C<max_ops> - the number of queued writes that triggers a flush.  The
+  default is 1000.
+* C<max_bytes> - the encoded size of the queued writes that triggers a
+  flush.  The default is 16MiB.
+* C<max_delay_ms> - the age of the oldest queued write, in milliseconds,
+  after which it is flushed.  The default is 100.
+
+See L<MongoDB::BufferedCollection> for how results and errors are reported.
+
+=cut
+
+sub buffered {
+    my ( $self, $options ) = @_;
+    $options ||= {};
+    return MongoDB::BufferedCollection->new( %$options, collection => $self );
+}
+
 =method bulk_write
 
     $res = $coll->bulk_write( [ @requests ], $options )
@@ -1581,6 +1705,13 @@ Valid options include:
 * C<ordered> – when true, the bulk operation is executed like
   L</initialize_ordered_bulk>. When false, the bulk operation is executed
   like L</initialize_unordered_bulk>.  The default is true.
+* C<summaryOnly> - when true, the result keeps only counts and the first
+  C<maxErrors> errors, so its size doesn't grow with the number of
+  operations.  See L<MongoDB::BulkWriteResult/is_summary>.
+* C<maxErrors> - with C<summaryOnly>, the number of errors kept.  The default
+  is 100.
+* C<encodeWorkers> - the number of processes to fork for encoding the
+  documents to insert.  See L<MongoDB::BulkWrite/encodeWorkers>.
 * C<session> - the session to use for these operations. If not supplied, will
   use an implicit session. For more information see L<MongoDB::ClientSession>
 
@@ -447,6 +447,68 @@ sub run_command {
     return $obj->output;
 }
 
+=method run_command_async
+
+    $database->run_command_async(
+        [ some_command => 1 ],
+        $read_preference,
+        $options,
+        sub {
+            my ( $output, $error ) = @_;
+            ...
+        }
+    );
+
+This method works like L</run_command>, but returns as soon as the command
+has been sent.  The last argument must be a callback.  When the reply
+arrives, it is called with the output of the command (a hash reference).  If
+the command fails, it is called with C<undef> and the error instead.  The
+read preference and options may be C<undef>.
+
+The reply is read by the event loop configured with
+L<MongoDB::MongoClient/io_backend>, so this is only useful inside a running
+event loop.  Each command in flight uses its own connection, up to
+L<MongoDB::MongoClient/max_pool_size> per server.  Asynchronous commands are
+not retried.
+
+=cut
+
+sub run_command_async {
+    my $cb = pop;
+    my ( $self, $command, $read_pref, $options ) = @_;
+    MongoDB::UsageError->throw("last argument must be a callback")
+       if ref($cb) ne 'CODE';
+    MongoDB::UsageError->throw("command was not an ordered document")
+       if ! is_OrderedDoc($command);
+
+    $read_pref = MongoDB::ReadPreference->new(
+        ref($read_pref) ? $read_pref : ( mode => $read_pref ) )
+      if $read_pref && ref($read_pref) ne 'MongoDB::ReadPreference';
+
+    my $session = $self->_client->_get_session_from_hashref( $options );
+
+    my $op = MongoDB::Op::_Command->_new(
+        client              => $self->_client,
+        db_name             => $self->name,
+        query               => $command,
+        query_flags         => {},
+        bson_codec          => $self->bson_codec,
+        read_preference     => $read_pref,
+        session             => $session,
+        monitoring_callback => $self->_client->monitoring_callback,
+    );
+
+    $self->_client->send_command_async(
+        $op, 'r',
+        sub {
+            my ( $result, $err ) = @_;
+            $cb->( $result ? $result->output : undef, $err );
+        }
+    );
+
+    return;
+}
+
 =method aggregate
 
 Runs a query using the MongoDB 3.6+ aggregation framework and returns a
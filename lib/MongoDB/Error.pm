@@ -662,6 +662,8 @@ These errors indicate a user-specified timeout has been exceeded.
 
 This error is thrown when a query or command fails because C<max_time_ms> has
 been reached.  The C<result> attribute is a L<MongoDB::CommandResult> object.
+It is also thrown, without a result, when an operation runs out of the time
+given by the client's C<timeout_ms>.
 
 =head3 MongoDB::NetworkTimeout
 
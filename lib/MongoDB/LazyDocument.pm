@@ -0,0 +1,172 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::LazyDocument;
+
+# ABSTRACT: A query result document decoded on demand
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use BSON::Raw;
+use MongoDB::Error;
+use MongoDB::_Protocol;
+
+# Not a Moo class: one of these is created for every document in a batch,
+# so it is a plain blessed array of the raw BSON, the codec and, once a
+# field has been looked at, the tied hash of fields.
+
+use overload
+  '%{}'    => \&_fields,
+  fallback => 1;
+
+sub _new {
+    my ( $class, $bson, $codec ) = @_;
+    return bless [ $bson, $codec ], $class;
+}
+
+=method bson
+
+    $raw_bytes = $doc->bson;
+
+Returns the document as it was received from the server, as a BSON
+encoded string.
+
+=cut
+
+sub bson { $_[0][0] }
+
+=method as_raw
+
+    $coll->insert_one( $doc->as_raw );
+
+Returns the document as a L<BSON::Raw> object, which can be passed to
+write methods without decoding and re-encoding it.
+
+=cut
+
+sub as_raw { BSON::Raw->new( bson => $_[0][0] ) }
+
+=method decoded
+
+    $hashref = $doc->decoded;
+
+Decodes the whole document with the collection's BSON codec and returns
+it as a new, modifiable document.
+
+=cut
+
+sub decoded { $_[0][1]->decode_one( $_[0][0] ) }
+
+sub _fields {
+    my ($self) = @_;
+    return $self->[2] ||= do {
+        tie my %fields, 'MongoDB::LazyDocument::_Fields', $self->[0], $self->[1];
+        \%fields;
+    };
+}
+
+package MongoDB::LazyDocument::_Fields;
+
+# Tied hash over the top-level fields of a BSON document.  Element offsets
+# are indexed the first time the hash is used; a field is decoded the
+# first time it is fetched and then cached.
+
+use MongoDB::_Constants;
+
+sub TIEHASH {
+    my ( $class, $bson, $codec ) = @_;
+    my ( @keys, %index );
+    for my $element ( MongoDB::_Protocol::index_document($bson) ) {
+        my $key = $element->[0];
+        utf8::decode($key);
+        push @keys, $key;
+        $index{$key} = $element;
+    }
+    return bless {
+        bson  => $bson,
+        codec => $codec,
+        keys  => \@keys,
+        index => \%index,
+        cache => {},
+        iter  => 0,
+    }, $class;
+}
+
+sub FETCH {
+    my ( $self, $key ) = @_;
+    return $self->{cache}{$key} if exists $self->{cache}{$key};
+    my $element = $self->{index}{$key}
+      or return;
+
+    # decode the element on its own by wrapping it in a document
+    my ( $start, $end ) = @{$element}[ 2, 4 ];
+    my $doc = $self->{codec}->decode_one(
+        join( '', pack( P_INT32, $end - $start + 5 ), substr( $self->{bson}, $start, $end - $start ), "\0" ) );
+    return $self->{cache}{$key} = $doc->{$key};
+}
+
+sub EXISTS { exists $_[0]{index}{ $_[1] } }
+
+sub FIRSTKEY {
+    my ($self) = @_;
+    $self->{iter} = 0;
+    return $self->{keys}[0];
+}
+
+sub NEXTKEY { $_[0]{keys}[ ++$_[0]{iter} ] }
+
+sub SCALAR { scalar @{ $_[0]{keys} } }
+
+sub STORE  { _read_only() }
+sub DELETE { _read_only() }
+sub CLEAR  { _read_only() }
+
+sub _read_only {
+    MongoDB::UsageError->throw(
+        "lazy documents are read-only; use the 'decoded' method for a copy to modify");
+}
+
+1;
+
+__END__
+
+=head1 SYNOPSIS
+
+    my $cursor = $coll->find( {}, { lazyDocuments => 1 } );
+
+    while ( my $doc = $cursor->next ) {
+        # only the 'status' field is decoded
+        next unless $doc->{status} eq 'ready';
+
+        # pass the original bytes along
+        $archive->insert_one( $doc->as_raw );
+    }
+
+=head1 DESCRIPTION
+
+Query results requested with the C<lazyDocuments> option are returned as
+objects of this class instead of decoded hash references.  The BSON of
+each document is kept as received and nothing is decoded until a field
+is accessed.
+
+Dereferencing the object as a hash gives a read-only view of the
+document's top-level fields.  Each field is decoded with the collection's
+BSON codec the first time it is fetched; listing the keys or checking
+whether a field exists decodes nothing.  Nested documents are decoded
+fully when their field is fetched.
+
+=cut
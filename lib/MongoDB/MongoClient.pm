@@ -58,10 +58,12 @@ use MongoDB::_Types qw(
     NonNegNum
     ReadPrefMode
     ReadPreference
+    ServerSelectionPolicy
     ZlibCompressionLevel
 );
 use Types::Standard qw(
     CodeRef
+    ConsumerOf
     HashRef
     ArrayRef
     InstanceOf
@@ -208,6 +210,32 @@ sub _build_auth_mechanism_properties {
     );
 }
 
+=attr background_monitoring
+
+Optional.  If true, servers are checked on a timer in the event loop given by
+L</io_backend>, every L</heartbeat_frequency_ms>, instead of by whichever
+operation finds the server information out of date.  Each check also
+verifies idle connections and opens connections up to L</min_pool_size>.
+Operations then skip the idle connection check described under
+L</socket_check_interval_ms>.  A scan still happens during an operation if
+the event loop falls a full heartbeat behind or after an error that makes
+the server information unreliable.  Requires an L</io_backend>.  Defaults to
+false.
+
+The checks use blocking I/O inside the event loop.  Each pass checks all
+servers at once, then verifies or opens connections one at a time, each from
+a timer of its own so that other events run in between.  A server that stops
+answering can still hold the loop for up to L</connect_timeout_ms> or
+L</socket_timeout_ms> at each of these steps.
+
+=cut
+
+has background_monitoring => (
+    is      => 'ro',
+    isa     => Boolish,
+    default => 0,
+);
+
 =attr bson_codec
 
 An object that provides the C<encode_one> and C<decode_one> methods, such as
@@ -278,6 +306,39 @@ sub _build_zlib_compression_level {
     );
 }
 
+=attr compression_min_bytes
+
+Messages smaller than this many bytes are sent uncompressed, even with
+L</compressors> set, since compressing them saves little and costs a call
+to the compressor.  Defaults to 1024.
+
+=cut
+
+has compression_min_bytes => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => 1024,
+);
+
+=attr compression_adaptive
+
+If true, the driver keeps track of how well each kind of command compresses
+and stops compressing those whose messages don't get at least 10% smaller,
+such as inserts of GridFS chunks holding compressed files.  One in 16 of
+those messages is still compressed, to notice if they start to compress
+better.  Defaults to false.
+
+Regardless of this setting, a message is sent uncompressed if compressing
+it doesn't make it smaller.
+
+=cut
+
+has compression_adaptive => (
+    is      => 'ro',
+    isa     => Boolish,
+    default => 0,
+);
+
 =attr connect_timeout_ms
 
 This attribute specifies the amount of time in milliseconds to wait for a
@@ -362,6 +423,35 @@ sub _build_heartbeat_frequency_ms {
     );
 }
 
+=attr io_backend
+
+Optional.  The event loop used by asynchronous methods such as
+L<MongoDB::Database/run_command_async>.  This may be C<AnyEvent> (which
+also covers applications running L<AnyEvent> on top of L<EV>, L<IO::Async>
+and others) or C<Mojo> (for the L<Mojo::IOLoop> singleton).  The
+corresponding module must be installed.  Without an I/O backend, asynchronous
+methods throw an error.
+
+=cut
+
+my %IO_BACKENDS = (
+    AnyEvent => 'MongoDB::_IOBackend::AnyEvent',
+    Mojo     => 'MongoDB::_IOBackend::Mojo',
+);
+
+has io_backend => (
+    is     => 'ro',
+    isa    => Maybe [ ConsumerOf ['MongoDB::Role::_IOBackend'] ],
+    coerce => sub {
+        my $name = shift;
+        return $name if !defined $name || ref $name;
+        my $class = $IO_BACKENDS{$name}
+          or MongoDB::UsageError->throw("Unknown io_backend '$name'");
+        eval "require $class; 1" or die $@; ## no critic
+        return $class->new;
+    },
+);
+
 =attr j
 
 If true, the client will block until write operations have been committed to the
@@ -423,6 +513,57 @@ sub _build_local_threshold_ms {
     );
 }
 
+=attr max_idle_time_ms
+
+The maximum number of milliseconds that a connection can remain idle in the
+connection pool before being closed.  Defaults to 0, which means idle
+connections are never closed for being idle.  Must be non-negative.
+
+This may be set in a connection string with the C<maxIdleTimeMS> option.
+
+=cut
+
+has max_idle_time_ms => (
+    is      => 'lazy',
+    isa     => NonNegNum,
+    builder => '_build_max_idle_time_ms',
+);
+
+sub _build_max_idle_time_ms {
+    my ($self) = @_;
+    return $self->__uri_or_else(
+        u => 'maxidletimems',
+        e => 'max_idle_time_ms',
+        d => 0,
+    );
+}
+
+=attr max_pool_size
+
+The maximum number of connections the client keeps to each server.  An
+operation that needs a connection when all of them are in use throws a
+L<MongoDB::ConnectionError>.  Defaults to 100.  A value of 0 means there is no
+limit.
+
+This may be set in a connection string with the C<maxPoolSize> option.
+
+=cut
+
+has max_pool_size => (
+    is      => 'lazy',
+    isa     => NonNegNum,
+    builder => '_build_max_pool_size',
+);
+
+sub _build_max_pool_size {
+    my ($self) = @_;
+    return $self->__uri_or_else(
+        u => 'maxpoolsize',
+        e => 'max_pool_size',
+        d => 100,
+    );
+}
+
 =attr max_staleness_seconds
 
 The C<max_staleness_seconds> parameter represents the maximum replication lag in
@@ -491,6 +632,31 @@ sub _build_max_time_ms {
     );
 }
 
+=attr min_pool_size
+
+The minimum number of connections the client keeps to each server.  Missing
+connections are opened the next time a server is selected for an operation.
+Defaults to 0.  It must not be larger than a nonzero L</max_pool_size>.
+
+This may be set in a connection string with the C<minPoolSize> option.
+
+=cut
+
+has min_pool_size => (
+    is      => 'lazy',
+    isa     => NonNegNum,
+    builder => '_build_min_pool_size',
+);
+
+sub _build_min_pool_size {
+    my ($self) = @_;
+    return $self->__uri_or_else(
+        u => 'minpoolsize',
+        e => 'min_pool_size',
+        d => 0,
+    );
+}
+
 =attr monitoring_callback
 
 Specifies a code reference used to receive monitoring events.  See
@@ -750,6 +916,29 @@ sub _build_retry_writes {
     );
 }
 
+=attr server_selection_policy
+
+How to choose among the suitable servers in the latency window (see
+L</SERVER SELECTION>).  Valid values are:
+
+=for :list
+* C<random> - any server in the window, at random.
+* C<least_loaded> - the less loaded of two servers from the window picked
+  at random.  A server's load is the number of operations this client has in
+  flight on it, plus one, times its recent average operation time.  This
+  steers operations away from a member that is temporarily slow, for
+  instance from a long-running query or a garbage collection pause.
+
+The default is C<random>.
+
+=cut
+
+has server_selection_policy => (
+    is      => 'ro',
+    isa     => ServerSelectionPolicy,
+    default => 'random',
+);
+
 =attr server_selection_timeout_ms
 
 This attribute specifies the amount of time in milliseconds to wait for a
@@ -1026,6 +1215,41 @@ sub __ssl_from_uri {
     return $ssl;
 }
 
+=attr timeout_ms
+
+The amount of time in milliseconds each operation may take in total.  It
+bounds server selection, socket reads and writes and any retry together, and
+the time remaining is sent to the server as C<maxTimeMS> (less the server's
+round trip time), so the server gives up on a command about when the driver
+would.  An operation that runs out of time throws a
+L<MongoDB::ExecutionTimeout|MongoDB::Error/MongoDB::ExecutionTimeout> or
+L<MongoDB::NetworkTimeout|MongoDB::Error/MongoDB::NetworkTimeout> error.
+
+A cursor's C<getMore> commands each get their own deadline, as does each
+batch of a prefetched or streamed cursor from when it is asked for.  Opening
+a new connection is still bounded by C<connect_timeout_ms>.
+
+The default is 0, which sets no deadline.
+
+This may be set in a connection string with the C<timeoutMS> option.
+
+=cut
+
+has timeout_ms => (
+    is      => 'lazy',
+    isa     => NonNegNum,
+    builder => '_build_timeout_ms',
+);
+
+sub _build_timeout_ms {
+    my ($self) = @_;
+    return $self->__uri_or_else(
+        u => 'timeoutms',
+        e => 'timeout_ms',
+        d => 0,
+    );
+}
+
 =attr username
 
 Optional username for this client connection.  If this field is set, the client
@@ -1275,6 +1499,7 @@ has _topology => (
         topology_type => 'type',
         _cluster_time => 'cluster_time',
         _update_cluster_time => 'update_cluster_time',
+        _defer_kill_cursors => 'defer_kill_cursors',
     },
     clearer  => '_clear__topology',
 );
@@ -1287,7 +1512,7 @@ sub _build__topology {
       : @{ $self->_uri->hostids } > 1     ? 'Sharded'
       :                                     'Direct';
 
-    MongoDB::_Topology->new(
+    my $topology = MongoDB::_Topology->new(
         uri                          => $self->_uri,
         type                         => $type,
         app_name                     => $self->app_name,
@@ -1311,9 +1536,20 @@ sub _build__topology {
         monitoring_callback => $self->monitoring_callback,
         compressors => $self->compressors,
         zlib_compression_level => $self->zlib_compression_level,
+        compression_min_bytes => $self->compression_min_bytes,
+        compression_adaptive => $self->compression_adaptive,
         socket_check_interval_sec => $self->socket_check_interval_ms / 1000,
         server_selector => $self->server_selector,
+        server_selection_policy => $self->server_selection_policy,
+        max_pool_size => $self->max_pool_size,
+        min_pool_size => $self->min_pool_size,
+        max_idle_time_sec => $self->max_idle_time_ms / 1000,
     );
+
+    $topology->start_background_monitor( $self->io_backend )
+      if $self->background_monitoring;
+
+    return $topology;
 }
 
 has _credential => (
@@ -1368,9 +1604,14 @@ has _dispatcher => (
     handles  => [
         qw(
           send_direct_op
+          start_direct_op
+          finish_direct_op
+          cancel_direct_op
+          abandon_direct_op
           send_primary_op
           send_retryable_read_op
           send_read_op
+          send_command_async
           send_retryable_write_op
           send_write_op
           )
@@ -1383,6 +1624,8 @@ sub _build__dispatcher {
         topology     => $self->_topology,
         retry_writes => $self->retry_writes,
         retry_reads  => $self->retry_reads,
+        io_backend   => $self->io_backend,
+        timeout_sec  => $self->timeout_ms / 1000,
     );
 }
 
@@ -1416,8 +1659,11 @@ my @deferred_options = qw(
   heartbeat_frequency_ms
   j
   local_threshold_ms
+  max_idle_time_ms
+  max_pool_size
   max_staleness_seconds
   max_time_ms
+  min_pool_size
   read_pref_mode
   read_pref_tag_sets
   replica_set_name
@@ -1428,6 +1674,7 @@ my @deferred_options = qw(
   socket_check_interval_ms
   socket_timeout_ms
   ssl
+  timeout_ms
   username
   password
   w
@@ -1482,6 +1729,12 @@ sub BUILD {
         );
     }
 
+    MongoDB::UsageError->throw("background_monitoring requires an io_backend")
+      if $self->background_monitoring && !$self->io_backend;
+
+    MongoDB::UsageError->throw("min_pool_size can't be larger than max_pool_size")
+      if $self->max_pool_size && $self->min_pool_size > $self->max_pool_size;
+
     # Instantiate topology
     $self->_topology;
 
@@ -1522,7 +1775,7 @@ automatically as needed.  It is kept for backwards compatibility.  Calling it
 will check all servers in the deployment which ensures a connection to any
 that are available.
 
-See L</reconnect> for a method that is useful when using forks or threads.
+See L</THREAD-SAFETY AND FORK-SAFETY> for using a client after forking.
 
 =cut
 
@@ -1552,7 +1805,8 @@ sub disconnect {
 
 This method closes all connections to the server, as if L</disconnect> were
 called, and then immediately reconnects.  It also clears the session
-cache.  Use this after forking or spawning off a new thread.
+cache.  Use this after spawning off a new thread.  It is not needed after
+forking; see L</THREAD-SAFETY AND FORK-SAFETY>.
 
 =cut
 
@@ -1658,6 +1912,18 @@ sub _start_client_session {
     );
 }
 
+# Sends at once the kills queued under a session that is about to end;
+# once its server session goes back to the pool they can't be sent with
+# it.  As with any kill, failures are ignored.
+sub _send_session_kills {
+    my ( $self, $session ) = @_;
+    for my $queued ( $self->_topology->take_session_kills($session) ) {
+        my ( $address, $op ) = @$queued;
+        eval { $self->send_direct_op( $op, $address ) };
+    }
+    return;
+}
+
 #--------------------------------------------------------------------------#
 # semi-private methods; these are public but undocumented and their
 # semantics might change in future releases
@@ -1998,6 +2264,10 @@ __END__
 connected
 send_admin_command
 send_direct_op
+start_direct_op
+finish_direct_op
+cancel_direct_op
+abandon_direct_op
 send_read_op
 send_write_op
 
@@ -2146,8 +2416,11 @@ The currently supported connection string options are:
 * C<heartbeatFrequencyMS>
 * C<journal>
 * C<localThresholdMS>
+* C<maxIdleTimeMS>
+* C<maxPoolSize>
 * C<maxStalenessSeconds>
 * C<maxTimeMS>
+* C<minPoolSize>
 * C<readConcernLevel>
 * C<readPreference>
 * C<readPreferenceTags>
@@ -2203,6 +2476,8 @@ selector and then at random from within the "latency window".  The server
 with the shortest average round-trip time (RTT) is always in the window.
 Any servers with an average round-trip time less than or equal to the
 shortest RTT plus the L</local_threshold_ms> are also in the latency window.
+With the L</server_selection_policy> set to C<least_loaded>, the less loaded
+of two random servers from the window is chosen instead.
 
 If a suitable server is not immediately available, what happens next
 depends on the L</server_selection_try_once> option.
@@ -2419,8 +2694,15 @@ C<auth_mechanism_properties> attribute or in the connection string.
 
 =head1 THREAD-SAFETY AND FORK-SAFETY
 
+A MongoDB::MongoClient detects when it is used in a forked child process.
+On the child's first operation, the connections and sessions it inherited are
+dropped without being closed on the parent's behalf, and new connections are
+made as they are needed; the known state of the deployment is kept, so
+forked workers don't all rescan it at once.  Cursors opened before the fork
+are left for the parent to close.
+
 You B<MUST> call the L</reconnect> method on any MongoDB::MongoClient objects
-after forking or spawning a thread.
+after spawning a thread.
 
 B<NOTE>: Per L<threads> documentation, use of Perl threads is discouraged by the
 maintainers of Perl and the MongoDB Perl driver does not test or provide support
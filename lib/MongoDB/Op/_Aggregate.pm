@@ -24,6 +24,7 @@ our $VERSION = 'v2.2.3';
 use Moo;
 
 use MongoDB::Op::_Command;
+use Scalar::Util qw/refaddr/;
 use MongoDB::_Types qw(
     ArrayOfHashRef
     Boolish
@@ -76,6 +77,46 @@ with $_ for qw(
 sub execute {
     my ( $self, $link, $topology ) = @_;
 
+    my $op = $self->_aggregate_command($link);
+    my $res = $op->execute( $link, $topology );
+
+    return $self->_aggregate_result( $res, $link );
+}
+
+# start and finish split the aggregate command in two, so that a hedged
+# read can wait on more than one server.  The command can be started on
+# several links at once.
+
+sub start {
+    my ( $self, $link, $topology ) = @_;
+    my $op = $self->_aggregate_command($link);
+    $self->{_pending}{ refaddr $link } = [ $op, $op->start( $link, $topology ) ];
+    return 1;
+}
+
+sub finish {
+    my ( $self, $link ) = @_;
+    my ( $op, $request_id ) = @{ delete $self->{_pending}{ refaddr $link } };
+    return $self->_aggregate_result( $op->read_reply( $link, $request_id ), $link );
+}
+
+# forgets a command started on $link whose reply won't be read here;
+# returns its request ID
+sub abandon {
+    my ( $self, $link ) = @_;
+    my $pending = delete $self->{_pending}{ refaddr $link };
+    return $pending ? $pending->[1] : undef;
+}
+
+# only plain reads may run twice
+sub is_hedgeable {
+    my ($self) = @_;
+    return !$self->has_out && !$self->options->{explain};
+}
+
+sub _aggregate_command {
+    my ( $self, $link ) = @_;
+
     my $options = $self->options;
     my $is_2_6 = $link->supports_write_commands;
 
@@ -144,7 +185,7 @@ sub execute {
         ),
     );
 
-    my $op = MongoDB::Op::_Command->_new(
+    return MongoDB::Op::_Command->_new(
         db_name     => $self->db_name,
         query       => Tie::IxHash->new(@command),
         query_flags => {},
@@ -153,10 +194,13 @@ sub execute {
         session             => $self->session,
         monitoring_callback => $self->monitoring_callback,
     );
+}
 
-    my $res = $op->execute( $link, $topology );
+sub _aggregate_result {
+    my ( $self, $res, $link ) = @_;
+    my $options = $self->options;
 
-    $res->assert_no_write_concern_error if $has_out;
+    $res->assert_no_write_concern_error if $self->has_out;
 
     # For explain, we give the whole response as fields have changed in
     # different server versions
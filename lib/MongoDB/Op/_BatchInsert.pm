@@ -87,7 +87,7 @@ sub execute {
 
     # XXX have to check size of docs to insert and possibly split it
     #
-    return ! $self->_should_use_acknowledged_write
+    return ! $self->_should_use_acknowledged_write && ! $link->supports_op_msg
       ? (
         $self->_send_legacy_op_noreply( $link,
             MongoDB::_Protocol::write_insert( $self->full_name, join( "", map { $_->{bson} } @insert_docs ) ),
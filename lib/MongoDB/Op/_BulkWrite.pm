@@ -31,14 +31,19 @@ use MongoDB::Op::_InsertOne;
 use MongoDB::Op::_Update;
 use MongoDB::Op::_Delete;
 use MongoDB::_Protocol;
+use MongoDB::_EncodePipeline;
 use MongoDB::_Constants;
 use MongoDB::_Types qw(
     Boolish
+    NonNegNum
+    Numish
 );
 use Types::Standard qw(
     ArrayRef
     InstanceOf
+    Undef
 );
+use List::Util qw/max/;
 use Safe::Isa;
 use boolean;
 
@@ -62,6 +67,20 @@ has client => (
     isa => InstanceOf['MongoDB::MongoClient'],
 );
 
+# keep a summary-only result with this many errors; see BulkWriteResult
+has max_errors => (
+    is  => 'ro',
+    isa => (Numish|Undef),
+);
+
+# number of processes encoding documents to insert; see _EncodePipeline
+has encode_workers => (
+    is       => 'ro',
+    isa      => NonNegNum,
+    init_arg => 'encodeWorkers',
+    default  => 0,
+);
+
 has _retryable => (
     is => 'rw',
     isa => Boolish,
@@ -125,6 +144,11 @@ sub execute {
         deleted_count        => 0,
         upserted             => [],
         inserted             => [],
+        (
+            defined $self->max_errors
+            ? ( _max_errors => max( 1, $self->max_errors ) )
+            : ()
+        ),
     );
 
     my @batches =
@@ -132,7 +156,12 @@ sub execute {
       ? $self->_batch_ordered( $link, $self->queue )
       : $self->_batch_unordered( $link, $self->queue );
 
+    my $pipeline = $use_write_cmd && $self->_encode_pipeline( $link, \@batches );
+
     for my $batch (@batches) {
+        if ($pipeline && $batch->[0] eq 'insert') {
+            $batch->[1] = [ $pipeline->take( scalar @{ $batch->[1] } ) ];
+        }
         if ($use_write_cmd) {
             $self->_execute_write_command_batch( $link, $batch, $result );
         }
@@ -155,154 +184,194 @@ sub execute {
     return $result;
 }
 
+# Starts encoding the documents to insert in worker processes, if there are
+# enough of them to make that worthwhile.  The workers are stopped when the
+# pipeline goes out of scope.
+sub _encode_pipeline {
+    my ( $self, $link, $batches ) = @_;
+    return unless $self->encode_workers;
+
+    my @docs = map { @{ $_->[1] } } grep { $_->[0] eq 'insert' } @$batches;
+    return unless @docs > MAX_WRITE_BATCH_SIZE;
+
+    return MongoDB::_EncodePipeline->new(
+        bson_codec    => $self->bson_codec,
+        docs          => \@docs,
+        workers       => $self->encode_workers,
+        max_bson_size => $link->max_bson_object_size,
+    )->start;
+}
+
 my %OP_MAP = (
     insert => [ insert => 'documents' ],
     update => [ update => 'updates' ],
     delete => [ delete => 'deletes' ],
 );
 
-# _execute_write_command_batch may split batches if they are too large and
-# execute them separately
+# _execute_write_command_batch encodes the batch one operation at a time and
+# sends a chunk as soon as the next operation would take it past the size
+# limit, so each operation is encoded exactly once
 
 sub _execute_write_command_batch {
     my ( $self, $link, $batch, $result ) = @_;
 
-    my ( $type, $docs, $idx_map )   = @$batch;
-    my ( $cmd,  $op_key ) = @{ $OP_MAP{$type} };
-
-    my $boolean_ordered = boolean( $self->ordered );
-    my ( $db_name, $coll_name, $wc ) =
-      map { $self->$_ } qw/db_name coll_name write_concern/;
-
-    my @left_to_send = ($docs);
-    my @sending_idx_map = ($idx_map);
+    my ( $type, $docs, $idx_map ) = @$batch;
+    my $cmd = $OP_MAP{$type}[0];
 
     my $max_bson_size = $link->max_bson_object_size;
-    my $supports_document_validation = $link->supports_document_validation;
-
-    while (@left_to_send) {
-        my $chunk = shift @left_to_send;
-        my $chunk_idx_map = shift @sending_idx_map;
-        # for update/insert, pre-encode docs as they need custom BSON handling
-        # that can't be applied to an entire write command at once
-        if ( $cmd eq 'update' ) {
-            # take array of hash, validate and encode each update doc; since this
-            # might be called more than once if chunks are getting split, check if
-            # the update doc is already encoded; this also removes the 'is_replace'
-            # field that needs to not be in the command sent to the server
-            for ( my $i = 0; $i <= $#$chunk; $i++ ) {
-                next if ref( $chunk->[$i]{u} ) eq 'BSON::Raw';
-                my $is_replace = delete $chunk->[$i]{is_replace};
-                $chunk->[$i]{u} = $self->_pre_encode_update( $max_bson_size, $chunk->[$i]{u}, $is_replace );
-            }
-        }
-        elsif ( $cmd eq 'insert' ) {
-            # take array of docs, encode each one while saving original or generated _id
-            # field; since this might be called more than once if chunks are getting
-            # split, check if the doc is already encoded
-            for ( my $i = 0; $i <= $#$chunk; $i++ ) {
-                unless ( ref( $chunk->[$i] ) eq 'BSON::Raw' ) {
-                    $chunk->[$i] = $self->_pre_encode_insert( $max_bson_size, $chunk->[$i], '.' );
-                };
-            }
+
+    # with OP_MSG each operation takes exactly its encoded length in the
+    # document sequence; otherwise it is an array element of the command
+    # document and also takes a type byte and its index as a key
+    my $use_op_msg = $link->supports_op_msg;
+    my $max_chunk_bytes =
+      ( $use_op_msg ? $link->max_message_size_bytes : MAX_BSON_WIRE_SIZE ) - MAX_COMMAND_OVERHEAD;
+
+    my ( $chunk, $chunk_ops, $chunk_idx_map, $chunk_bytes ) = ( [], [], [], 0 );
+
+    for my $i ( 0 .. $#$docs ) {
+        my ( $encoded, $op ) = $self->_encode_batch_op( $cmd, $docs->[$i], $max_bson_size );
+        my $len = length $encoded->{bson};
+        my $size = $use_op_msg ? $len : $len + 2 + length scalar @$chunk;
+
+        if ( @$chunk && $chunk_bytes + $size > $max_chunk_bytes ) {
+            $self->_execute_write_command_chunk( $link, $type, $chunk, $chunk_ops, $chunk_idx_map,
+                $result );
+            ( $chunk, $chunk_ops, $chunk_idx_map, $chunk_bytes ) = ( [], [], [], 0 );
+            $size = $use_op_msg ? $len : $len + 3;
         }
 
-        my $cmd_doc = [
-            $cmd         => $coll_name,
-            $op_key      => $chunk,
-            ordered      => $boolean_ordered,
-            @{ $wc->as_args },
-        ];
+        push @$chunk,         $encoded;
+        push @$chunk_ops,     $op;
+        push @$chunk_idx_map, $idx_map->[$i];
+        $chunk_bytes += $size;
+    }
 
-        if ( $cmd eq 'insert' || $cmd eq 'update' ) {
-            $cmd_doc = $self->_maybe_bypass( $supports_document_validation, $cmd_doc );
-        }
+    $self->_execute_write_command_chunk( $link, $type, $chunk, $chunk_ops, $chunk_idx_map, $result )
+      if @$chunk;
 
-        my $op = MongoDB::Op::_Command->_new(
-            db_name             => $db_name,
-            query               => $cmd_doc,
-            query_flags         => {},
-            bson_codec          => $self->bson_codec,
-            session             => $self->session,
-            retryable_write     => $self->retryable_write,
-            monitoring_callback => $self->monitoring_callback,
-        );
-
-        my $cmd_result = eval {
-            $self->_is_retryable
-              ? $self->client->send_retryable_write_op( $op )
-              : $self->client->send_write_op( $op );
-        } or do {
-            my $error = $@ || "Unknown error";
-            # This error never touches the database!.... so is before any retryable writes errors etc.
-            if ( $error->$_isa("MongoDB::_CommandSizeError") ) {
-                if ( @$chunk == 1 ) {
-                    MongoDB::DocumentError->throw(
-                        message  => "document too large",
-                        document => $chunk->[0],
-                    );
-                }
-                else {
-                    unshift @left_to_send, $self->_split_chunk( $chunk, $error->size );
-                    unshift @sending_idx_map, $self->_split_chunk( $chunk_idx_map, $error->size );
-                }
-            }
-            elsif ( $error->$_can( 'result' ) ) {
-                # We are already going to explode from something here, but
-                # BulkWriteResult has the correct parsing method to allow us to
-                # check for write errors, as they have a higher priority than
-                # write concern errors.
-                MongoDB::BulkWriteResult->_parse_cmd_result(
-                    op       => $type,
-                    op_count => scalar @$chunk,
-                    result   => $error->result,
-                    cmd_doc  => $cmd_doc,
-                    idx_map  => $chunk_idx_map,
-                )->assert_no_write_error;
-                # Explode with original error
-                die $error;
-            }
-            else {
-                die $error;
-            }
-        };
+    return;
+}
 
-        redo unless $cmd_result; # restart after a chunk split
+# Returns an operation encoded as BSON::Raw along with the operation to
+# report in write errors.  Inserts and update documents need custom BSON
+# handling that can't be applied to an entire write command at once.
 
-        my $r = MongoDB::BulkWriteResult->_parse_cmd_result(
-            op       => $type,
-            op_count => scalar @$chunk,
-            result   => $cmd_result,
-            cmd_doc  => $cmd_doc,
-            idx_map  => $chunk_idx_map,
-        );
+sub _encode_batch_op {
+    my ( $self, $cmd, $doc, $max_bson_size ) = @_;
 
-        # append corresponding ops to errors
-        if ( $r->count_write_errors ) {
-            for my $error ( @{ $r->write_errors } ) {
-                $error->{op} = $chunk->[ $error->{index} ];
-            }
-        }
+    if ( $cmd eq 'insert' ) {
+        # encode while saving the original or generated _id field
+        $doc = $self->_pre_encode_insert( $max_bson_size, $doc, '.' )
+          unless ref($doc) eq 'BSON::Raw';
+        return ( $doc, $doc );
+    }
 
-        $result->_merge_result($r);
-        $result->assert_no_write_error if $boolean_ordered;
+    if ( $cmd eq 'update' && ref( $doc->{u} ) ne 'BSON::Raw' ) {
+        # validate and encode the update doc; this also removes the
+        # 'is_replace' field that needs to not be in the command sent to
+        # the server
+        my $is_replace = delete $doc->{is_replace};
+        $doc->{u} = $self->_pre_encode_update( $max_bson_size, $doc->{u}, $is_replace );
     }
 
-    return;
+    # manually bless for speed
+    return ( bless( { bson => $self->bson_codec->encode_one($doc) }, "BSON::Raw" ), $doc );
 }
 
-sub _split_chunk {
-    my ( $self, $chunk, $size ) = @_;
+# Sends one chunk of a batch.  The chunk is cut to fit, so a size error
+# only happens if the command fields outgrow MAX_COMMAND_OVERHEAD; the
+# chunk is then halved, reusing the already encoded operations.
+
+sub _execute_write_command_chunk {
+    my ( $self, $link, $type, $chunk, $chunk_ops, $chunk_idx_map, $result ) = @_;
+
+    my ( $cmd, $op_key ) = @{ $OP_MAP{$type} };
+    my $boolean_ordered = boolean( $self->ordered );
+
+    my $cmd_doc = [
+        $cmd         => $self->coll_name,
+        $op_key      => $chunk,
+        ordered      => $boolean_ordered,
+        @{ $self->write_concern->as_args },
+    ];
+
+    if ( $cmd eq 'insert' || $cmd eq 'update' ) {
+        $cmd_doc = $self->_maybe_bypass( $link->supports_document_validation, $cmd_doc );
+    }
+
+    my $op = MongoDB::Op::_Command->_new(
+        db_name             => $self->db_name,
+        query               => $cmd_doc,
+        query_flags         => {},
+        bson_codec          => $self->bson_codec,
+        session             => $self->session,
+        retryable_write     => $self->retryable_write,
+        monitoring_callback => $self->monitoring_callback,
+        unacknowledged      => !$self->_should_use_acknowledged_write,
+    );
 
-    my $avg_cmd_size       = $size / @$chunk;
-    my $new_cmds_per_chunk = int( MAX_BSON_WIRE_SIZE / $avg_cmd_size );
+    my $cmd_result = eval {
+        $self->_is_retryable
+          ? $self->client->send_retryable_write_op( $op )
+          : $self->client->send_write_op( $op );
+    } or do {
+        my $error = $@ || "Unknown error";
+        # This error never touches the database!.... so is before any retryable writes errors etc.
+        if ( $error->$_isa("MongoDB::_CommandSizeError") ) {
+            if ( @$chunk == 1 ) {
+                MongoDB::DocumentError->throw(
+                    message  => "document too large",
+                    document => $chunk_ops->[0],
+                );
+            }
+            my $half = int( @$chunk / 2 );
+            for my $part ( [ 0, $half - 1 ], [ $half, $#$chunk ] ) {
+                my @range = $part->[0] .. $part->[1];
+                $self->_execute_write_command_chunk( $link, $type, [ @{$chunk}[@range] ],
+                    [ @{$chunk_ops}[@range] ], [ @{$chunk_idx_map}[@range] ], $result );
+            }
+            return;
+        }
+        elsif ( $error->$_can( 'result' ) ) {
+            # We are already going to explode from something here, but
+            # BulkWriteResult has the correct parsing method to allow us to
+            # check for write errors, as they have a higher priority than
+            # write concern errors.
+            MongoDB::BulkWriteResult->_parse_cmd_result(
+                op       => $type,
+                op_count => scalar @$chunk,
+                result   => $error->result,
+                cmd_doc  => $cmd_doc,
+                idx_map  => $chunk_idx_map,
+            )->assert_no_write_error;
+            # Explode with original error
+            die $error;
+        }
+        else {
+            die $error;
+        }
+    };
+
+    my $r = MongoDB::BulkWriteResult->_parse_cmd_result(
+        op       => $type,
+        op_count => scalar @$chunk,
+        result   => $cmd_result,
+        cmd_doc  => $cmd_doc,
+        idx_map  => $chunk_idx_map,
+    );
 
-    my @split_chunks;
-    while (@$chunk) {
-        push @split_chunks, [ splice( @$chunk, 0, $new_cmds_per_chunk ) ];
+    # append corresponding ops to errors
+    if ( $r->count_write_errors && !$result->is_summary ) {
+        for my $error ( @{ $r->write_errors } ) {
+            $error->{op} = $chunk_ops->[ $error->{index} ];
+        }
     }
 
-    return @split_chunks;
+    $result->_merge_result($r);
+    $result->assert_no_write_error if $boolean_ordered;
+
+    return;
 }
 
 sub _batch_ordered {
@@ -25,10 +25,12 @@ use Moo;
 
 use MongoDB::_Constants;
 use MongoDB::_Types qw(
+    Boolish
     Document
     ReadPreference
     to_IxHash
 );
+use MongoDB::LazyDocument;
 use List::Util qw/first/;
 use Types::Standard qw(
     CodeRef
@@ -58,6 +60,30 @@ has read_preference => (
     isa => Maybe [ReadPreference],
 );
 
+# for w:0 writes: over OP_MSG the command is sent with moreToCome and
+# without a session, and no reply is read
+has unacknowledged => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
+# ask the server to stream further replies with moreToCome; only for
+# callers that read them with read_reply
+has exhaust_allowed => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
+# leave the documents of a cursor batch in the reply encoded, as
+# MongoDB::LazyDocument objects
+has lazy_documents => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
 with $_ for qw(
   MongoDB::Role::_PrivateConstructor
   MongoDB::Role::_DatabaseOp
@@ -79,11 +105,154 @@ my %IS_NOT_COMPRESSIBLE = map { ($_ => 1) } qw(
     copydb
 );
 
+# commands for which maxTimeMS means something else or isn't allowed
+my %NO_DEADLINE_MAX_TIME = map { ($_ => 1) } qw(
+    getmore
+    killcursors
+    endsessions
+);
+
 sub execute {
     my ( $self, $link, $topology_type ) = @_;
+
+    my ( $op_bson, $request_id, $write_opt ) = $self->_prepare_message( $link, $topology_type );
+    my $more_to_come = $self->_is_more_to_come($link);
+
+    my $reply = $link->reply_buffer;
+    eval {
+        $link->write( $op_bson, $write_opt ),
+        ( $more_to_come || $link->read($reply) );
+    };
+    if ( my $err = $@ ) {
+        $self->_update_session_connection_error( $err );
+        $self->publish_command_exception($err) if $self->monitoring_callback;
+        die $err;
+    }
+
+    return $more_to_come
+      ? $self->_unacknowledged_result($link)
+      : $self->_handle_reply( $link, $$reply, $request_id );
+}
+
+# Writes the command without reading the reply, for callers that wait on
+# several links at once; returns the request ID to pass to read_reply.
+sub start {
+    my ( $self, $link, $topology_type ) = @_;
+
+    my ( $op_bson, $request_id, $write_opt ) = $self->_prepare_message( $link, $topology_type );
+    eval { $link->write( $op_bson, $write_opt ) };
+    if ( my $err = $@ ) {
+        $self->_update_session_connection_error( $err );
+        $self->publish_command_exception($err) if $self->monitoring_callback;
+        die $err;
+    }
+
+    return $request_id;
+}
+
+sub _is_more_to_come {
+    my ( $self, $link ) = @_;
+    return $self->{unacknowledged} && $link->supports_op_msg;
+}
+
+# Reads and handles the reply to a message from _prepare_message that the
+# caller has written to the link.  If the server set moreToCome on the
+# reply, another one follows without a new request: more_to_come is then
+# true and calling this again reads it.
+sub read_reply {
+    my ( $self, $link, $request_id ) = @_;
+    $request_id = delete $self->{_more_reply_to} if defined $self->{_more_reply_to};
+
+    my $reply = $link->reply_buffer;
+    eval { $link->read($reply) };
+    if ( my $err = $@ ) {
+        $self->_update_session_connection_error( $err );
+        $self->publish_command_exception($err) if $self->monitoring_callback;
+        die $err;
+    }
+
+    return $self->_handle_reply( $link, $$reply, $request_id );
+}
+
+sub more_to_come { defined $_[0]{_more_reply_to} }
+
+# size of the last reply document, uncompressed
+sub reply_size { $_[0]{_reply_size} }
+
+# there is no reply to check after a moreToCome write; report success
+sub _unacknowledged_result {
+    my ( $self, $link ) = @_;
+
+    $self->publish_command_reply( { ok => 1 } )
+      if $self->monitoring_callback;
+
+    return MongoDB::CommandResult->_new(
+        output  => { ok => 1 },
+        address => $link->address,
+    );
+}
+
+# Sends all the commands on one link before reading any replies, so a burst
+# of independent commands costs a single round trip.  Replies are matched to
+# commands by responseTo.  Returns, in order, a MongoDB::CommandResult for
+# each command that succeeded or the error for each one that failed; network
+# errors fail the whole batch and are thrown.
+sub execute_pipelined {
+    my ( $class, $link, $ops, $topology_type ) = @_;
+
+    # pipelining relies on OP_MSG; older servers get one command at a time
+    unless ( $link->supports_op_msg ) {
+        return map {
+            my $op = $_;
+            my $res = eval { $op->execute( $link, $topology_type ) };
+            defined $res ? $res : $@;
+        } @$ops;
+    }
+
+    # unacknowledged commands get no reply, so their request IDs are not
+    # waited for
+    my ( @msgs, @request_ids, @write_opts );
+    for my $op (@$ops) {
+        my ( $op_bson, $request_id, $write_opt ) = $op->_prepare_message( $link, $topology_type );
+        push @msgs,        $op_bson;
+        push @request_ids, $op->_is_more_to_come($link) ? undef : $request_id;
+        push @write_opts,  $write_opt;
+    }
+
+    my $replies;
+    eval {
+        $link->write_many( \@msgs, \@write_opts ),
+        ( $replies = $link->read_replies( [ grep { defined } @request_ids ] ) );
+    };
+    if ( my $err = $@ ) {
+        for my $op (@$ops) {
+            $op->_update_session_connection_error( $err );
+            $op->publish_command_exception($err) if $op->monitoring_callback;
+        }
+        die $err;
+    }
+
+    return map {
+        my ( $op, $request_id ) = ( $ops->[$_], $request_ids[$_] );
+        my $res = eval {
+            defined $request_id
+              ? $op->_handle_reply( $link, $replies->{$request_id}, $request_id )
+              : $op->_unacknowledged_result($link);
+        };
+        defined $res ? $res : $@;
+    } 0 .. $#$ops;
+}
+
+sub _prepare_message {
+    my ( $self, $link, $topology_type ) = @_;
     $topology_type ||= 'Single'; # if not specified, assume direct
 
-    $self->_apply_session_and_cluster_time( $link, \$self->{query} );
+    my $more_to_come = $self->_is_more_to_come($link);
+
+    $self->_apply_deadline($link) if defined $link->{deadline};
+
+    $self->_apply_session_and_cluster_time( $link, \$self->{query} )
+      unless $more_to_come;
 
     my ( $op_bson, $request_id );
 
@@ -92,8 +261,12 @@ sub execute {
         $self->_apply_op_msg_read_prefs( $link, $topology_type, $self->{query_flags}, \$self->{query});
         $self->{query} = to_IxHash( $self->{query} );
         $self->{query}->Push( '$db', $self->db_name );
+        my $flags =
+            $more_to_come ? { more_to_come => 1 }
+          : $self->{exhaust_allowed} && $link->supports_exhaust_allowed ? { exhaust_allowed => 1 }
+          : undef;
         ( $op_bson, $request_id ) =
-            MongoDB::_Protocol::write_msg( $self->{bson_codec}, undef, $self->{query} );
+            MongoDB::_Protocol::write_msg( $self->{bson_codec}, $flags, $self->{query} );
     } else {
         # $query is passed as a reference because it *may* be replaced
         $self->_apply_op_query_read_prefs( $link, $topology_type, $self->{query_flags}, \$self->{query});
@@ -102,7 +275,15 @@ sub execute {
             $self->{bson_codec}->encode_one( $self->{query} ), undef, 0, -1, $self->{query_flags});
     }
 
-    if ( length($op_bson) > MAX_BSON_WIRE_SIZE ) {
+    # with OP_MSG, write command documents travel in a document sequence
+    # outside the command document and are only bound by the message size
+    my $max_size =
+      $link->supports_op_msg
+      && MongoDB::_Protocol::has_document_sequence( _get_command_name( $self->{query} ) )
+      ? $link->max_message_size_bytes
+      : MAX_BSON_WIRE_SIZE;
+
+    if ( length($op_bson) > $max_size ) {
         # XXX should this become public?
         MongoDB::_CommandSizeError->throw(
             message => "database command too large",
@@ -113,26 +294,56 @@ sub execute {
     $self->publish_command_started( $link, $self->{query}, $request_id )
       if $self->monitoring_callback;
 
+    my $command_name = _get_command_name( $self->{query} );
     my %write_opt = (
-        disable_compression => $IS_NOT_COMPRESSIBLE{ _get_command_name( $self->{query} ) },
+        disable_compression => $IS_NOT_COMPRESSIBLE{$command_name},
+        command_name        => $command_name,
     );
 
-    my $result;
-    eval {
-        $link->write( $op_bson, \%write_opt ),
-        ( $result = MongoDB::_Protocol::parse_reply( $link->read, $request_id ) );
-    };
+    return ( $op_bson, $request_id, \%write_opt );
+}
+
+# With an operation deadline, the server gets what is left of it, less a
+# round trip, as maxTimeMS; a smaller maxTimeMS already on the command is
+# kept.  Throws if no time is left to send the command at all.
+sub _apply_deadline {
+    my ( $self, $link ) = @_;
+    return if $NO_DEADLINE_MAX_TIME{ lc _get_command_name( $self->{query} ) };
+
+    my $rtt = $link->server ? $link->server->rtt_sec : 0;
+    my $max_time_ms = int( ( $link->{deadline} - time - $rtt ) * 1000 );
+    MongoDB::ExecutionTimeout->throw("operation exceeded its timeout before it was sent")
+      if $max_time_ms <= 0;
+
+    $self->{query} = to_IxHash( $self->{query} );
+    my $current = $self->{query}->FETCH('maxTimeMS');
+    $self->{query}->Push( maxTimeMS => $max_time_ms )
+      unless $current && $current <= $max_time_ms;
+
+    return;
+}
+
+# The reply is left in $_[2] rather than copied; parse_reply works on it in place.
+sub _handle_reply {
+    my ( $self, $link, undef, $request_id ) = @_;
+
+    my $result = eval { MongoDB::_Protocol::parse_reply( $_[2], $request_id ) };
     if ( my $err = $@ ) {
         $self->_update_session_connection_error( $err );
         $self->publish_command_exception($err) if $self->monitoring_callback;
         die $err;
     }
 
+    # a streamed reply is answered by the next one
+    $self->{_more_reply_to} = $result->{request_id}
+      if $result->{flags}{more_to_come};
+    $self->{_reply_size} = length $result->{docs};
+
     $self->publish_command_reply( $result->{docs} )
       if $self->monitoring_callback;
 
     my $res = MongoDB::CommandResult->_new(
-        output => $self->{bson_codec}->decode_one( $result->{docs} ),
+        output => $self->_decode_output( $result->{docs} ),
         address => $link->address,
         session => $self->session,
     );
@@ -148,6 +359,20 @@ sub execute {
     return $res;
 }
 
+sub _decode_output {
+    my ( $self, $bson ) = @_;
+    my $codec = $self->{bson_codec};
+
+    return $codec->decode_one($bson) unless $self->{lazy_documents};
+
+    my ( $rest, $docs, $batch_key ) = MongoDB::_Protocol::split_cursor_batch($bson);
+    return $codec->decode_one($bson) unless $docs;
+
+    my $output = $codec->decode_one($rest);
+    $output->{cursor}{$batch_key} = [ map { MongoDB::LazyDocument->_new( $_, $codec ) } @$docs ];
+    return $output;
+}
+
 sub _get_command_name {
     my ($doc) = @_;
     my $type = ref $doc;
@@ -82,7 +82,7 @@ sub execute {
     };
 
     return (
-        ! $self->_should_use_acknowledged_write
+        ! $self->_should_use_acknowledged_write && ! $link->supports_op_msg
         ? (
             $self->_send_legacy_op_noreply(
                 $link,
@@ -31,6 +31,7 @@ use Types::Standard qw(
   Any
 );
 use MongoDB::_Types qw(
+    Boolish
     Numish
 );
 
@@ -53,6 +54,19 @@ has max_time_ms => (
     isa => Numish,
 );
 
+# let the server stream batches; only honoured by start and finish
+has exhaust => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
+has lazy_documents => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
 with $_ for qw(
   MongoDB::Role::_PrivateConstructor
   MongoDB::Role::_CollectionOp
@@ -71,19 +85,85 @@ sub execute {
     return $res;
 }
 
+# start and finish split a command getMore in two, so a cursor can send the
+# request for its next batch while still working through the current one.
+# start returns false if the link needs a legacy OP_GET_MORE instead.
+#
+# With exhaust, the server keeps streaming batches after the first reply.
+# finish then returns more_to_come and the link must be kept for further
+# calls to finish, which read the next batch without sending anything.
+
+sub start {
+    my ( $self, $link ) = @_;
+    return 0 unless $link->supports_query_commands;
+
+    my $op = $self->{_pending_command} = $self->_get_more_command( $self->exhaust );
+    my ( $op_bson, $request_id, $write_opt ) = $op->_prepare_message($link);
+    $self->{_pending_request_id} = $request_id;
+
+    eval { $link->write( $op_bson, $write_opt ) };
+    if ( my $err = $@ ) {
+        $op->_update_session_connection_error( $err );
+        $op->publish_command_exception($err) if $op->monitoring_callback;
+        die $err;
+    }
+
+    return 1;
+}
+
+sub finish {
+    my ( $self, $link ) = @_;
+    my $op         = delete $self->{_pending_command};
+    my $request_id = delete $self->{_pending_request_id};
+
+    my $res = $self->_command_result( $op->read_reply( $link, $request_id ), $op->reply_size );
+
+    if ( $op->more_to_come ) {
+        $self->{_pending_command} = $op;
+        $res->{more_to_come} = 1;
+    }
+
+    return $res;
+}
+
+# forgets a getMore started on $link whose reply won't be read here;
+# returns its request ID
+sub abandon {
+    my ($self) = @_;
+    delete $self->{_pending_command};
+    return delete $self->{_pending_request_id};
+}
+
+# true while batches are being streamed to the link
+sub is_streaming {
+    my ($self) = @_;
+    return $self->{_pending_command} && $self->{_pending_command}->more_to_come;
+}
+
 sub _command_get_more {
     my ( $self, $link ) = @_;
+    my $op = $self->_get_more_command;
+    return $self->_command_result( $op->execute($link), $op->reply_size );
+}
 
-    my $op = MongoDB::Op::_Command->_new(
+sub _get_more_command {
+    my ( $self, $exhaust ) = @_;
+    return MongoDB::Op::_Command->_new(
         db_name             => $self->db_name,
         query               => $self->_as_command,
         query_flags         => {},
         bson_codec          => $self->bson_codec,
         session             => $self->session,
         monitoring_callback => $self->monitoring_callback,
+        lazy_documents      => $self->lazy_documents,
+        exhaust_allowed     => $exhaust,
     );
+}
+
+sub _command_result {
+    my ( $self, $res, $reply_bytes ) = @_;
 
-    my $c = $op->execute($link)->output->{cursor};
+    my $c = $res->output->{cursor};
     my $batch = $c->{nextBatch} || [];
 
     return {
@@ -92,9 +172,12 @@ sub _command_get_more {
         starting_from   => 0,
         number_returned => scalar @$batch,
         docs            => $batch,
+        reply_bytes     => $reply_bytes,
     };
 }
 
+sub _lazy_documents { $_[0]{lazy_documents} }
+
 sub _as_command {
     my ($self) = @_;
     return [
@@ -25,7 +25,7 @@ our $VERSION = 'v2.2.3';
 use boolean;
 use Moo;
 
-use Scalar::Util qw/blessed/;
+use Scalar::Util qw/blessed refaddr/;
 use List::Util qw/min/;
 use MongoDB::QueryResult;
 use MongoDB::QueryResult::Filtered;
@@ -111,7 +111,52 @@ sub execute {
 sub _command_query {
     my ( $self, $link, $topology ) = @_;
 
-    my $op = MongoDB::Op::_Command->_new(
+    my $op = $self->_find_command;
+    my $res = $op->execute( $link, $topology );
+
+    return $self->_build_result_from_cursor( $res, $op->reply_size );
+}
+
+# start and finish split a command query in two, so that a hedged read can
+# wait on more than one server.  The query can be started on several links
+# at once.  start returns false if the link needs a legacy OP_QUERY instead.
+
+sub start {
+    my ( $self, $link, $topology ) = @_;
+    return 0 unless $link->supports_query_commands;
+
+    if ( defined $self->{options}{collation} and !$link->supports_collation ) {
+        MongoDB::UsageError->throw(
+            "MongoDB host '" . $link->address . "' doesn't support collation" );
+    }
+
+    my $op = $self->_find_command;
+    $self->{_pending}{ refaddr $link } = [ $op, $op->start( $link, $topology ) ];
+
+    return 1;
+}
+
+sub finish {
+    my ( $self, $link ) = @_;
+    my ( $op, $request_id ) = @{ delete $self->{_pending}{ refaddr $link } };
+    my $res = $op->read_reply( $link, $request_id );
+    return $self->_build_result_from_cursor( $res, $op->reply_size );
+}
+
+# forgets a query started on $link whose reply won't be read here; returns
+# its request ID
+sub abandon {
+    my ( $self, $link ) = @_;
+    my $pending = delete $self->{_pending}{ refaddr $link };
+    return $pending ? $pending->[1] : undef;
+}
+
+# tailable cursors wait for data, so a slow first reply means nothing
+sub is_hedgeable { $_[0]{options}{cursorType} eq 'non_tailable' }
+
+sub _find_command {
+    my ($self) = @_;
+    return MongoDB::Op::_Command->_new(
         db_name             => $self->db_name,
         query               => $self->_as_command,
         query_flags         => {},
@@ -119,10 +164,8 @@ sub _command_query {
         bson_codec          => $self->bson_codec,
         session             => $self->session,
         monitoring_callback => $self->monitoring_callback,
+        lazy_documents      => $self->_lazy_documents,
     );
-    my $res = $op->execute( $link, $topology );
-
-    return $self->_build_result_from_cursor($res);
 }
 
 sub _legacy_query {
@@ -182,9 +225,20 @@ sub _legacy_query {
         _cursor_num   => $result->{number_returned},
         _docs         => $result->{docs},
         _post_filter  => $self->post_filter,
+        _lazy_documents => $self->_lazy_documents,
     );
 }
 
+sub _lazy_documents { $_[0]{options}{lazyDocuments} }
+
+sub _prefetch { $_[0]{options}{prefetch} || 0 }
+
+sub _exhaust { $_[0]{options}{exhaust} ? 1 : 0 }
+
+sub _target_batch_bytes { $_[0]{options}{targetBatchBytes} || 0 }
+
+sub _max_batch_bytes { $_[0]{options}{maxBatchBytes} || 0 }
+
 # awful hack: avoid calling into boolean to get true/false
 my $TRUE  = boolean::true();
 my $FALSE = boolean::false();
@@ -232,7 +286,8 @@ sub _as_query_document {
 }
 
 my %options_to_prune =
-  map { $_ => 1 } qw/limit batchSize cursorType maxAwaitTimeMS modifiers/;
+  map { $_ => 1 } qw/limit batchSize cursorType maxAwaitTimeMS modifiers lazyDocuments prefetch exhaust
+    targetBatchBytes maxBatchBytes/;
 
 sub _as_command {
     my ($self) = @_;
@@ -318,6 +373,19 @@ sub precondition_options {
         # hashref
         ( defined $opts->{projection} ? ( projection => $opts->{projection} ) : () ),
 
+        # boolean, driver only
+        ( $opts->{lazyDocuments} ? ( lazyDocuments => 1 ) : () ),
+
+        # integer, driver only
+        ( $opts->{prefetch} ? ( prefetch => $opts->{prefetch} ) : () ),
+
+        # boolean, driver only
+        ( $opts->{exhaust} ? ( exhaust => 1 ) : () ),
+
+        # integers, driver only
+        ( $opts->{targetBatchBytes} ? ( targetBatchBytes => $opts->{targetBatchBytes} ) : () ),
+        ( $opts->{maxBatchBytes}    ? ( maxBatchBytes    => $opts->{maxBatchBytes} )    : () ),
+
         # hashref
         ( defined $opts->{collation} ? ( collation => $opts->{collation} ) : () ),
 
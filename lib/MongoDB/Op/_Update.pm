@@ -136,7 +136,7 @@ sub execute {
         $orig_op,
         "MongoDB::UpdateResult",
         "update",
-    ) if ! $self->_should_use_acknowledged_write;
+    ) if ! $self->_should_use_acknowledged_write && ! $link->supports_op_msg;
 
     return $self->_send_write_command(
         $link,
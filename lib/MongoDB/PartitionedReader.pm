@@ -0,0 +1,364 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::PartitionedReader;
+
+# ABSTRACT: Reads a collection in key ranges over several connections or processes
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use B ();
+use List::Util qw/min/;
+use Scalar::Util qw/blessed/;
+use MongoDB::Error;
+use MongoDB::_Platform;
+use MongoDB::_Types qw(
+    Document
+    MongoDBCollection
+    NonEmptyStr
+    NonNegNum
+);
+use Types::Standard qw(
+    ArrayRef
+    HashRef
+    Int
+);
+
+use namespace::clean -except => 'meta';
+
+has _collection => (
+    is       => 'ro',
+    isa      => MongoDBCollection,
+    init_arg => 'collection',
+    required => 1,
+);
+
+has _filter => (
+    is       => 'ro',
+    isa      => Document,
+    init_arg => 'filter',
+    default  => sub { {} },
+);
+
+has _partitions => (
+    is       => 'ro',
+    isa      => Int,
+    init_arg => 'partitions',
+    default  => 4,
+);
+
+has _key => (
+    is       => 'ro',
+    isa      => NonEmptyStr,
+    init_arg => 'key',
+    default  => '_id',
+);
+
+has _sample_size => (
+    is       => 'lazy',
+    isa      => Int,
+    init_arg => 'sample_size',
+    builder  => sub { 100 * $_[0]->_partitions },
+);
+
+# zero runs partitions in this process
+has _workers => (
+    is       => 'ro',
+    isa      => NonNegNum,
+    init_arg => 'workers',
+    default  => 0,
+);
+
+# passed to find for each range
+has _find_options => (
+    is       => 'ro',
+    isa      => HashRef,
+    init_arg => 'find_options',
+    default  => sub { {} },
+);
+
+has _ranges => (
+    is       => 'lazy',
+    isa      => ArrayRef,
+    init_arg => undef,
+    builder  => '_build__ranges',
+);
+
+# query results still being read by next_batch, in turn
+has _results => (
+    is       => 'lazy',
+    isa      => ArrayRef,
+    init_arg => undef,
+    builder  => '_build__results',
+);
+
+=method ranges
+
+    @filters = $reader->ranges;
+
+Returns the filter document of each partition.  Every document matching the
+reader's filter matches exactly one of them.
+
+=cut
+
+sub ranges { @{ $_[0]->_ranges } }
+
+# Boundaries come from $bucketAuto over a random sample of the key.  The
+# server only compares values of the same kind (numbers with numbers,
+# strings with strings and so on), so boundaries are grouped by kind and
+# each group's last range is left open above.  The first range takes
+# whatever is not at or above the first boundary of any group: documents
+# without the key, with a key of a kind that has no boundaries, or below
+# the first boundary of their kind.
+sub _build__ranges {
+    my ($self) = @_;
+    my $key = $self->_key;
+
+    my @bounds;
+    if ( $self->_partitions > 1 ) {
+        my @pipeline = (
+            ( $self->_has_filter ? { '$match' => $self->_filter } : () ),
+            { '$sample'     => { size    => $self->_sample_size } },
+            { '$bucketAuto' => { groupBy => "\$$key", buckets => $self->_partitions } },
+        );
+        @bounds = map { $_->{_id}{min} } $self->_collection->aggregate( \@pipeline )->all;
+        shift @bounds;
+    }
+
+    return [ $self->_filter ] unless @bounds;
+
+    # $bucketAuto sorts its output, so values of a kind are adjacent
+    my @groups;
+    for my $bound (@bounds) {
+        my $kind = _kind_of($bound);
+        push @groups, [ $kind ] unless @groups && $groups[-1][0] eq $kind;
+        push @{ $groups[-1] }, $bound;
+    }
+
+    my @firsts = map { $_->[1] } @groups;
+    my @ranges = (
+        @firsts == 1
+        ? { $key => { '$not' => { '$gte' => $firsts[0] } } }
+        : { '$nor' => [ map { { $key => { '$gte' => $_ } } } @firsts ] }
+    );
+    for my $group (@groups) {
+        my ( undef, @group_bounds ) = @$group;
+        for my $i ( 0 .. $#group_bounds ) {
+            push @ranges,
+              {
+                $key => {
+                    '$gte' => $group_bounds[$i],
+                    ( $i < $#group_bounds ? ( '$lt' => $group_bounds[ $i + 1 ] ) : () ),
+                }
+              };
+        }
+    }
+
+    return $self->_has_filter
+      ? [ map { { '$and' => [ $self->_filter, $_ ] } } @ranges ]
+      : \@ranges;
+}
+
+my %KIND_OF_CLASS = (
+    'BSON::Bool'       => 'bool',
+    'BSON::Bytes'      => 'binData',
+    'BSON::Decimal128' => 'number',
+    'BSON::Double'     => 'number',
+    'BSON::Int32'      => 'number',
+    'BSON::Int64'      => 'number',
+    'BSON::MaxKey'     => 'maxKey',
+    'BSON::MinKey'     => 'minKey',
+    'BSON::OID'        => 'objectId',
+    'BSON::Regex'      => 'regex',
+    'BSON::String'     => 'string',
+    'BSON::Symbol'     => 'string',
+    'BSON::Time'       => 'date',
+    'BSON::Timestamp'  => 'timestamp',
+    'DateTime'         => 'date',
+    'DateTime::Tiny'   => 'date',
+    'Math::BigFloat'   => 'number',
+    'Math::BigInt'     => 'number',
+    'Time::Moment'     => 'date',
+    'boolean'          => 'bool',
+);
+
+# The kind of value a decoded boundary is, as the server groups them for
+# comparisons.  Plain scalars are numbers only if they have no string value,
+# as the BSON encoder sees them.
+sub _kind_of {
+    my ($value) = @_;
+    return 'null' unless defined $value;
+    if ( my $class = blessed $value ) {
+        return $KIND_OF_CLASS{$class} || $class;
+    }
+    if ( ref $value ) {
+        return ref $value eq 'ARRAY' ? 'array' : 'object';
+    }
+    my $flags = B::svref_2object( \$value )->FLAGS;
+    return ( $flags & ( B::SVf_IOK | B::SVf_NOK ) ) && !( $flags & B::SVf_POK )
+      ? 'number'
+      : 'string';
+}
+
+sub _has_filter {
+    my ($self) = @_;
+    my $filter = $self->_filter;
+    return !( ref $filter eq 'HASH' && !%$filter );
+}
+
+sub _find {
+    my ( $self, $range, @options ) = @_;
+    return $self->_collection->find( $range, { %{ $self->_find_options }, @options } )->result;
+}
+
+=method next_batch
+
+    while ( my @batch = $reader->next_batch ) {
+        process_doc($_) for @batch;
+    }
+
+Returns the next batch of documents from any partition, or an empty list
+once all partitions are exhausted.  The partitions are queried together,
+over a connection each, and batches are taken from them in turn.  While a
+batch is being processed, the next batch of every partition is already on
+its way.  Documents are returned in no particular order.
+
+=cut
+
+sub next_batch {
+    my ($self) = @_;
+    my $results = $self->_results;
+    while ( my $result = shift @$results ) {
+        my @batch = $result->batch
+          or next;
+        push @$results, $result;
+        return @batch;
+    }
+    return;
+}
+
+sub _build__results {
+    my ($self) = @_;
+    return [ map { $self->_find( $_, prefetch => 1 ) } $self->ranges ];
+}
+
+=method each_partition
+
+    $reader->each_partition(
+        sub {
+            my ( $result, $filter, $index ) = @_;
+            while ( my @batch = $result->batch ) {
+                ...
+            }
+        }
+    );
+
+Calls the given code reference for each partition with a
+L<MongoDB::QueryResult> for it, the partition's filter document and its
+index in L</ranges>.
+
+With C<workers> set, that many processes are forked and the partitions are
+divided between them; each process makes its own connections to the
+deployment as it runs its share.  Anything the callback needs to pass back
+must go through files, pipes or the database.  The method returns once
+every worker has exited and throws an error if any of them failed.  Without
+workers, the partitions are read one after another in this process.
+
+=cut
+
+sub each_partition {
+    my ( $self, $cb ) = @_;
+    my @ranges = $self->ranges;
+
+    my $workers = min( $self->_workers, scalar @ranges );
+    unless ($workers) {
+        $cb->( $self->_find( $ranges[$_] ), $ranges[$_], $_ ) for 0 .. $#ranges;
+        return;
+    }
+
+    MongoDB::_Platform::flush_std_handles();
+
+    my @pids;
+    for my $worker ( 0 .. $workers - 1 ) {
+        my $pid = fork;
+        MongoDB::Error->throw("Couldn't fork partition worker: $!")
+          unless defined $pid;
+        if ( !$pid ) {
+            my $ok = eval {
+                for ( my $i = $worker ; $i < @ranges ; $i += $workers ) {
+                    $cb->( $self->_find( $ranges[$i] ), $ranges[$i], $i );
+                }
+                1;
+            };
+            warn "partition worker $worker failed: $@" unless $ok;
+            # the exit status is all the parent learns about the worker
+            MongoDB::_Platform::exit_forked_worker( $ok ? 0 : 1 );
+        }
+        push @pids, $pid;
+    }
+
+    my @failed = grep { waitpid( $pids[$_], 0 ); $? } 0 .. $#pids;
+    MongoDB::Error->throw( "partition workers failed: " . join( ", ", @failed ) )
+      if @failed;
+
+    return;
+}
+
+1;
+
+__END__
+
+=head1 SYNOPSIS
+
+    my $reader = $coll->partitioned_reader(
+        { status => 'active' },
+        { partitions => 8 }
+    );
+
+    # merged batches from concurrent queries
+    while ( my @batch = $reader->next_batch ) {
+        ...
+    }
+
+    # or one process per partition
+    $coll->partitioned_reader( {}, { partitions => 8, workers => 8 } )
+      ->each_partition( sub {
+        my ( $result, $filter, $index ) = @_;
+        my $out = path("export-$index.json")->openw_utf8;
+        while ( my @batch = $result->batch ) {
+            print {$out} map { encode_json($_) . "\n" } @batch;
+        }
+      } );
+
+=head1 DESCRIPTION
+
+This class splits a collection into ranges of a key, C<_id> by default,
+and reads the ranges in parallel.  It is returned by
+L<MongoDB::Collection/partitioned_reader>.
+
+The range boundaries are taken from a random sample of the key with the
+C<$bucketAuto> aggregation stage, so the partitions hold about the same
+number of documents.  Partitions are most even when the key has a single
+BSON type; documents without the key, or whose key has a different type from
+the sampled values, are all read with the first partition.
+
+Ranges of an indexed key can each be read with an index scan.  For a
+sharded collection, partitioning on the shard key keeps each range on few
+shards.
+
+=cut
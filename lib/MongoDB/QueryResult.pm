@@ -28,6 +28,7 @@ use MongoDB::Op::_GetMore;
 use MongoDB::Op::_KillCursors;
 use MongoDB::_Types qw(
     BSONCodec
+    Boolish
     ClientSession
     HostAddress
     Intish
@@ -91,6 +92,90 @@ has _session => (
     isa => Maybe[ClientSession],
 );
 
+# return MongoDB::LazyDocument objects instead of decoded documents
+has _lazy_documents => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
+# when no more than this many documents are left in the buffer, the next
+# getMore is sent and its reply collected once the buffer is empty; zero
+# disables prefetching
+has _prefetch => (
+    is      => 'ro',
+    default => 0,
+    isa     => Numish,
+);
+
+# adaptive batch sizing: getMore batch sizes aim at replies of this many
+# bytes, from the size of the documents seen so far; zero disables it
+has _target_batch_bytes => (
+    is      => 'ro',
+    default => 0,
+    isa     => Numish,
+);
+
+# with adaptive sizing, no batch may hold more than this many bytes of
+# documents at the largest per-batch average size seen so far; zero means
+# no cap
+has _max_batch_bytes => (
+    is      => 'ro',
+    default => 0,
+    isa     => Numish,
+);
+
+# size of the reply that carried the first batch, if known
+has _reply_bytes => (
+    is  => 'ro',
+    isa => Numish,
+);
+
+# process the cursor was opened in; a forked child leaves it to the parent
+has _pid => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { $$ },
+);
+
+# bytes per document: a moving average weighted toward recent batches, and
+# the largest average of any single batch
+has _avg_doc_bytes => (
+    is       => 'rw',
+    init_arg => undef,
+    default  => 0,
+    isa      => Numish,
+);
+
+has _max_doc_bytes => (
+    is       => 'rw',
+    init_arg => undef,
+    default  => 0,
+    isa      => Numish,
+);
+
+# getMore with exhaustAllowed, so the server streams the remaining batches
+# over one link without waiting for a request for each
+has _exhaust => (
+    is      => 'ro',
+    default => 0,
+    isa     => Boolish,
+);
+
+# the getMore op and link of a prefetch or exhaust stream in flight
+has _prefetching => (
+    is       => 'rw',
+    init_arg => undef,
+    isa      => Maybe [ArrayRef],
+);
+
+# error from starting a prefetch, thrown by the next _get_more so that the
+# documents already taken off the buffer still reach the caller
+has _prefetch_error => (
+    is       => 'rw',
+    init_arg => undef,
+);
+
 # attributes for tracking progress
 
 has _cursor_at => (
@@ -176,6 +261,12 @@ sub _drain_docs {
 # for backwards compatibility
 sub started_iterating() { 1 }
 
+sub BUILD {
+    my ($self) = @_;
+    $self->_observe_batch( $self->_reply_bytes, $self->_doc_count )
+      if $self->_target_batch_bytes;
+}
+
 sub _info {
     my ($self) = @_;
     return {
@@ -223,7 +314,9 @@ sub next {
     my ($self) = @_;
     return unless $self->has_next;
     $self->_inc_cursor_at();
-    return $self->_next_doc;
+    my $doc = $self->_next_doc;
+    $self->_try_prefetch if $self->{_prefetch};
+    return $doc;
 }
 
 =method batch
@@ -241,19 +334,124 @@ Returns the next batch of documents or an empty list if the server cursor is exh
 sub batch {
   my ($self) = @_;
   return unless $self->has_next;
-  return $self->_drain_docs;
+  my @docs = $self->_drain_docs;
+  $self->_try_prefetch if $self->{_prefetch};
+  return @docs;
 }
 
 sub _get_more {
     my ($self) = @_;
-    return 0 if $self->_cursor_id == 0;
+
+    if ( defined( my $err = $self->_prefetch_error ) ) {
+        $self->_prefetch_error(undef);
+        die $err;
+    }
+
+    my $result;
+    if ( my $prefetching = $self->_prefetching ) {
+        $self->_prefetching(undef);
+        $result = $self->_client->finish_direct_op(@$prefetching);
+        $self->_prefetching($prefetching) if $result->{more_to_come};
+    }
+    else {
+        return 0 if $self->_cursor_id == 0;
+        my $op = $self->_get_more_op;
+        my $link;
+        if ( $self->{_exhaust} ) {
+            $link = $self->_client->start_direct_op( $op, $self->_address );
+            # legacy getMore can't stream; don't try again
+            $self->{_exhaust} = 0 unless $link;
+        }
+        if ($link) {
+            $result = $self->_client->finish_direct_op( $op, $link );
+            $self->_prefetching( [ $op, $link ] ) if $result->{more_to_come};
+        }
+        else {
+            $result = $self->_client->send_direct_op( $op, $self->_address );
+        }
+    }
+
+    $self->_set_cursor_id( $result->{cursor_id} );
+    $self->_set_cursor_flags( $result->{flags} );
+    $self->_set_cursor_start( $result->{starting_from} );
+    $self->_inc_cursor_num( $result->{number_returned} );
+    $self->_add_docs( @{ $result->{docs} } );
+    $self->_set_post_batch_resume_token($result->{cursor}{postBatchResumeToken});
+    $self->_observe_batch( $result->{reply_bytes}, $result->{number_returned} )
+      if $self->{_target_batch_bytes};
+    return scalar @{ $result->{docs} };
+}
+
+# Each batch's bytes per document is averaged in with a weight of one half,
+# an exponentially weighted moving average that smooths out batch to batch
+# variation for the target while following a change in document size within
+# a few batches.  The cap is held against the largest per-batch average seen;
+# single documents larger than that are not tracked.
+sub _observe_batch {
+    my ( $self, $bytes, $count ) = @_;
+    return unless $bytes && $count;
+    my $per_doc = $bytes / $count;
+    my $avg = $self->{_avg_doc_bytes};
+    $self->_avg_doc_bytes( $avg ? ( $avg + $per_doc ) / 2 : $per_doc );
+    $self->_max_doc_bytes($per_doc) if $per_doc > $self->{_max_doc_bytes};
+    return;
+}
+
+sub _adaptive_batch_size {
+    my ($self) = @_;
+    my $avg = $self->{_avg_doc_bytes}
+      or return $self->_batch_size;
+    my $size = int( $self->{_target_batch_bytes} / $avg );
+    if ( my $cap = $self->{_max_batch_bytes} ) {
+        my $most = int( $cap / $self->{_max_doc_bytes} );
+        $size = $most if $size > $most;
+    }
+    return $size < 1 ? 1 : $size;
+}
+
+sub _try_prefetch {
+    my ($self) = @_;
+    return if defined $self->_prefetch_error;
+    eval { $self->_maybe_prefetch; 1 }
+      or $self->_prefetch_error( length($@) ? $@ : "caught error, but it was lost in eval unwind" );
+    return;
+}
+
+sub _maybe_prefetch {
+    my ($self) = @_;
+    return if $self->_prefetching
+      || $self->_cursor_id == 0
+      || $self->_doc_count > $self->{_prefetch};
+
+    my $limit = $self->_limit;
+    return if $limit > 0 && $limit - $self->_cursor_at - $self->_doc_count <= 0;
+
+    my $op = $self->_get_more_op;
+    if ( my $link = $self->_client->start_direct_op( $op, $self->_address ) ) {
+        $self->_prefetching( [ $op, $link ] );
+    }
+    else {
+        # legacy getMore can't be split; don't try again
+        $self->{_prefetch} = 0;
+    }
+    return;
+}
+
+# documents still buffered are not yet counted in _cursor_at, so they are
+# taken off what is left of the limit
+sub _get_more_op {
+    my ($self) = @_;
 
     my $limit = $self->_limit;
-    my $want = $limit > 0 ? ( $limit - $self->_cursor_at ) : $self->_batch_size;
+    my $want = $self->{_target_batch_bytes} ? $self->_adaptive_batch_size : $self->_batch_size;
+    if ( $limit > 0 ) {
+        my $left = $limit - $self->_cursor_at - $self->_doc_count;
+        $want = $left unless $self->{_target_batch_bytes} && $want && $want < $left;
+    }
 
     my ($db_name, $coll_name) = split(/\./, $self->_full_name, 2);
 
-    my $op = MongoDB::Op::_GetMore->_new(
+    return MongoDB::Op::_GetMore->_new(
         full_name  => $self->_full_name,
         db_name    => $db_name,
         coll_name  => $coll_name,
@@ -264,17 +462,9 @@ sub _get_more {
         ( $self->_max_time_ms ? ( max_time_ms => $self->_max_time_ms ) : () ),
         session             => $self->_session,
         monitoring_callback => $self->_client->monitoring_callback,
+        lazy_documents      => $self->_lazy_documents,
+        exhaust             => $self->_exhaust,
     );
-
-    my $result = $self->_client->send_direct_op( $op, $self->_address );
-
-    $self->_set_cursor_id( $result->{cursor_id} );
-    $self->_set_cursor_flags( $result->{flags} );
-    $self->_set_cursor_start( $result->{starting_from} );
-    $self->_inc_cursor_num( $result->{number_returned} );
-    $self->_add_docs( @{ $result->{docs} } );
-    $self->_set_post_batch_resume_token($result->{cursor}{postBatchResumeToken});
-    return scalar @{ $result->{docs} };
 }
 
 =method all
@@ -292,8 +482,35 @@ sub all {
     return @ret;
 }
 
+# With $defer, the kill is queued on the topology to go out in a batch with
+# others for the same server and session, the next time a link to the
+# server is checked in.  The queued op holds on to the session, so an
+# implicit session isn't returned to the pool while its cursor is open.
 sub _kill_cursor {
-    my ($self) = @_;
+    my ( $self, $defer ) = @_;
+
+    # the link of a prefetch must be read clear before it can be reused; the
+    # reply also says whether the cursor is still open.  A deferred kill
+    # leaves that to the topology, which kills the cursor if the reply says
+    # it is open.  A stream of exhaust replies has no end in sight, so its
+    # link is closed instead.
+    if ( my $prefetching = $self->_prefetching ) {
+        $self->_prefetching(undef);
+        if ( $prefetching->[0]->is_streaming ) {
+            $self->_client->cancel_direct_op(@$prefetching);
+        }
+        elsif ($defer) {
+            $self->_client->abandon_direct_op(@$prefetching);
+            $self->_set_cursor_id(0);
+        }
+        else {
+            my $result = eval { $self->_client->finish_direct_op(@$prefetching) };
+            $self->_set_cursor_id( $result ? $result->{cursor_id} : 0 );
+            $self->_client->cancel_direct_op(@$prefetching)
+              if $result && $result->{more_to_come};
+        }
+    }
+
     my $cursor_id = $self->_cursor_id;
     return if !defined $cursor_id || $cursor_id == 0;
 
@@ -304,17 +521,23 @@ sub _kill_cursor {
         full_name           => $self->_full_name,
         bson_codec          => $self->_bson_codec,
         cursor_ids          => [$cursor_id],
-        client              => $self->_client,
-        session             => $self->_session,
         monitoring_callback => $self->_client->monitoring_callback,
+        session             => $self->_session,
     );
-    $self->_client->send_direct_op( $op, $self->_address );
+    if ($defer) {
+        $self->_client->_defer_kill_cursors( $self->_address, $op );
+    }
+    else {
+        $self->_client->send_direct_op( $op, $self->_address );
+    }
     $self->_set_cursor_id(0);
 }
 
 sub DEMOLISH {
-    my ($self) = @_;
-    $self->_kill_cursor;
+    my ( $self, $in_global_destruction ) = @_;
+    # the server times out cursors left open at exit
+    return if $in_global_destruction || $self->{_pid} != $$;
+    $self->_kill_cursor(1);
 }
 
 =head1 SYNOPSIS
@@ -351,8 +574,12 @@ are recommended:
 
 =head2 Cursor destruction
 
-When a C<MongoDB::QueryResult> object is destroyed, a cursor termination
-request will be sent to the originating server to free server resources.
+When a C<MongoDB::QueryResult> object is destroyed before its results are
+exhausted, the server cursor is queued for termination to free server
+resources.  Queued cursors are terminated together, with a single request
+per collection, the next time a connection to the originating server is
+returned to its pool, or after a few seconds or once a hundred have been
+queued, whichever comes first.
 
 =head2 Multithreading
 
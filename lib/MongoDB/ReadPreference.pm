@@ -22,6 +22,7 @@ use version;
 our $VERSION = 'v2.2.3';
 
 use Moo;
+use boolean;
 use MongoDB::Error;
 use MongoDB::_Types qw(
     ArrayOfHashRef
@@ -29,6 +30,10 @@ use MongoDB::_Types qw(
     NonNegNum
     ReadPrefMode
 );
+use Types::Standard qw(
+    HashRef
+    Maybe
+);
 use namespace::clean -except => 'meta';
 
 use overload (
@@ -90,6 +95,36 @@ has max_staleness_seconds => (
     default => -1,
 );
 
+=attr hedge
+
+Hedged read options, as a hash reference; C<< { enabled => 1 } >> turns
+hedging on.  A hedged read is sent to a second suitable server if the first
+is slow to reply, and the first reply to come back is used.
+
+With a sharded cluster, the option is passed to mongos (MongoDB 4.4 or
+later), which hedges reads to the members of each shard.  With a replica
+set, the driver hedges finds and aggregations itself: if the selected
+member hasn't replied after the 95th percentile of its recent read times,
+the read is sent to another suitable member as well.  Any cursor opened by
+the read that lost is killed.
+
+If the C<mode> is 'primary', then C<hedge> must not be supplied.
+
+=cut
+
+has hedge => (
+    is  => 'ro',
+    isa => Maybe [HashRef],
+);
+
+# read preferences are immutable, so the string that tells them apart in the
+# topology's selection cache is only built once
+has _cache_key => (
+    is       => 'lazy',
+    init_arg => undef,
+    builder  => 'as_string',
+);
+
 sub BUILD {
     my ($self) = @_;
 
@@ -101,6 +136,10 @@ sub BUILD {
         MongoDB::UsageError->throw("A positive max_staleness_seconds is not allowed with read preference mode 'primary'");
     }
 
+    if ( $self->mode eq 'primary' && $self->hedge ) {
+        MongoDB::UsageError->throw("Hedge options are not allowed with read preference mode 'primary'");
+    }
+
     return;
 }
 
@@ -124,6 +163,21 @@ sub _as_hashref {
     };
 }
 
+sub is_hedged {
+    my ($self) = @_;
+    return $self->{hedge} && $self->{hedge}{enabled};
+}
+
+# Like _as_hashref, with the hedge options that only mongos understands
+
+sub _as_mongos_hashref {
+    my ($self) = @_;
+    my $doc = $self->_as_hashref;
+    $doc->{hedge} = { enabled => $self->is_hedged ? true : false }
+      if $self->hedge;
+    return $doc;
+}
+
 # Format as a string for error messages
 
 sub as_string {
@@ -147,7 +201,7 @@ sub as_string {
 
 __END__
 
-=for Pod::Coverage has_empty_tag_sets for_mongos as_string
+=for Pod::Coverage has_empty_tag_sets for_mongos as_string is_hedged
 
 =head1 SYNOPSIS
 
@@ -30,8 +30,9 @@ use namespace::clean;
 
 requires qw/session client bson_codec/;
 
+# $reply_bytes, the size of the reply, seeds adaptive batch sizing
 sub _build_result_from_cursor {
-    my ( $self, $res ) = @_;
+    my ( $self, $res, $reply_bytes ) = @_;
 
     my $c = $res->output->{cursor}
       or MongoDB::DatabaseError->throw(
@@ -52,8 +53,17 @@ sub _build_result_from_cursor {
     }
 
     my $limit = 0;
+    my $lazy_documents = 0;
+    my $prefetch = 0;
+    my $exhaust = 0;
+    my ( $target_batch_bytes, $max_batch_bytes ) = ( 0, 0 );
     if ($self->isa('MongoDB::Op::_Query')) {
         $limit = $self->options->{limit} if $self->options->{limit};
+        $lazy_documents = $self->_lazy_documents;
+        $prefetch = $self->_prefetch;
+        $exhaust = $self->_exhaust;
+        $target_batch_bytes = $self->_target_batch_bytes;
+        $max_batch_bytes = $self->_max_batch_bytes;
     }
 
     my $batch = $c->{firstBatch};
@@ -73,6 +83,12 @@ sub _build_result_from_cursor {
         _max_time_ms  => $max_time_ms,
         _session       => $self->session,
 	_post_batch_resume_token => $c->{postBatchResumeToken},
+        _lazy_documents => $lazy_documents,
+        _prefetch       => $prefetch,
+        _exhaust        => $exhaust,
+        _target_batch_bytes => $target_batch_bytes,
+        _max_batch_bytes    => $max_batch_bytes,
+        ( $reply_bytes ? ( _reply_bytes => $reply_bytes ) : () ),
     );
 }
 
@@ -0,0 +1,35 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+use strict;
+use warnings;
+package MongoDB::Role::_IOBackend;
+
+# MongoDB interface for the event loop adaptors that drive asynchronous
+# operations.  Consumers must provide:
+#
+# * watch_read( $fh, $cb ) -- calls $cb each time $fh becomes readable
+# * timer( $seconds, $cb ) -- calls $cb once after $seconds
+#
+# Both return a guard object; the watcher or timer is cancelled when the
+# guard goes out of scope.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo::Role;
+use namespace::clean;
+
+requires qw/watch_read timer/;
+
+1;
@@ -37,6 +37,10 @@ sub _pre_encode_insert {
 
     my $type = ref($doc);
 
+    # already returned by this method, e.g. for a buffered write
+    return $doc
+      if $type eq 'BSON::Raw' && $doc->{metadata} && defined $doc->{metadata}{_id};
+
     my $id = (
           $type eq 'HASH' ? $doc->{_id}
         : $type eq 'ARRAY' || $type eq 'BSON::Doc' ? do {
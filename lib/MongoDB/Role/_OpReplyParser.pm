@@ -24,6 +24,7 @@ our $VERSION = 'v2.2.3';
 use Moo::Role;
 
 use MongoDB::Error;
+use MongoDB::LazyDocument;
 use MongoDB::_Protocol;
 use MongoDB::_Constants;
 
@@ -33,7 +34,7 @@ with $_ for qw(
   MongoDB::Role::_CommandMonitoring
 );
 
-requires '_as_command';
+requires qw/_as_command _lazy_documents/;
 
 # Sends a BSON query/get-more string, then read, parse and validate the reply.
 # Throws various errors if the results indicate a problem.  Returns
@@ -48,6 +49,7 @@ sub _query_and_receive {
     my ($self, $link, $op_bson, $request_id) = @_;
 
     my ($result, $doc_bson, $bson_codec, $docs, $len, $i);
+    my $lazy = $self->_lazy_documents;
 
     $self->publish_command_started( $link, $self->_as_command, $request_id )
       if $self->monitoring_callback;
@@ -73,7 +75,9 @@ sub _query_and_receive {
             $len = unpack( P_INT32, $doc_bson );
             MongoDB::ProtocolError->throw("document in response at index $i was truncated")
             if $len > length($doc_bson);
-            $docs->[ $i++ ] = $bson_codec->decode_one( substr( $doc_bson, 0, $len, '' ) );
+            $docs->[ $i++ ] = $lazy
+              ? MongoDB::LazyDocument->_new( substr( $doc_bson, 0, $len, '' ), $bson_codec )
+              : $bson_codec->decode_one( substr( $doc_bson, 0, $len, '' ) );
         }
 
         MongoDB::ProtocolError->throw(
@@ -90,6 +94,7 @@ sub _query_and_receive {
     }
 
     if ($result->{flags}{query_failure}) {
+        $result->{docs}[0] = $result->{docs}[0]->decoded if $lazy;
         $self->publish_legacy_query_error( $result->{docs}[0] )
           if $self->monitoring_callback;
         # had query_failure, so pretend the query was a command and assert it here
@@ -42,9 +42,13 @@ sub _apply_op_msg_read_prefs {
 
     $topology_type ||= "<undef>";
     my $read_pref = $self->read_preference;
-    my $read_pref_doc = $read_pref ? $read_pref->_as_hashref : $PRIMARY;
+    my $to_mongos = $topology_type eq 'Sharded' || ( $link->server && $link->server->type eq 'Mongos' );
+    my $read_pref_doc =
+        !$read_pref ? $PRIMARY
+      : $to_mongos  ? $read_pref->_as_mongos_hashref
+      :               $read_pref->_as_hashref;
 
-    if ( $topology_type eq 'Single' && ! ($link->server && $link->server->type eq 'Mongos') ) {
+    if ( $topology_type eq 'Single' && ! $to_mongos ) {
         # For direct connection to a non-mongos single server, allow any server
         # type, overriding the provided read preference
         $read_pref_doc = $PRIMARYPREFERRED;
@@ -104,7 +108,9 @@ sub _apply_mongos_read_prefs {
     elsif ( $mode eq 'secondaryPreferred' ) {
         $query_flags->{slave_ok} = 1;
         $need_read_pref = 1
-          unless $read_pref->has_empty_tag_sets && $read_pref->max_staleness_seconds == -1;
+          unless $read_pref->has_empty_tag_sets
+          && $read_pref->max_staleness_seconds == -1
+          && !$read_pref->hedge;
     }
     else {
         MongoDB::InternalError->throw("invalid read preference mode '$mode'");
@@ -115,7 +121,7 @@ sub _apply_mongos_read_prefs {
         if ( !($$query_ref)->FETCH('$query') ) {
             $$query_ref = Tie::IxHash->new( '$query' => $$query_ref );
         }
-        ($$query_ref)->Push( '$readPreference' => $read_pref->_as_hashref );
+        ($$query_ref)->Push( '$readPreference' => $read_pref->_as_mongos_hashref );
     }
 
     return;
@@ -163,17 +163,23 @@ sub _send_legacy_op_noreply {
     );
 }
 
+# Unacknowledged writes over OP_MSG set the moreToCome flag, so the server
+# sends no reply and the write returns once the message is written.  Like
+# the legacy unacknowledged ops, they are sent without a session.
+
 sub _send_write_command {
     my ( $self, $link, $cmd, $op_doc, $result_class ) = @_;
 
-    $self->_apply_session_and_cluster_time( $link, \$cmd );
+    my $more_to_come = $link->supports_op_msg && !$self->_should_use_acknowledged_write;
+
+    $self->_apply_session_and_cluster_time( $link, \$cmd ) unless $more_to_come;
 
     my ( $op_bson, $request_id );
     if ( $link->supports_op_msg ) {
         $cmd = to_IxHash( $cmd );
         $cmd->Push( '$db', $self->db_name );
-        ( $op_bson, $request_id ) =
-            MongoDB::_Protocol::write_msg( $self->bson_codec, undef, $cmd );
+        ( $op_bson, $request_id ) = MongoDB::_Protocol::write_msg( $self->bson_codec,
+            ( $more_to_come ? { more_to_come => 1 } : undef ), $cmd );
     } else {
         # send command and get response document
         my $command = $self->bson_codec->encode_one( $cmd );
@@ -196,7 +202,7 @@ sub _send_write_command {
     my $result;
     eval {
         $link->write( $op_bson ),
-        ( $result = MongoDB::_Protocol::parse_reply( $link->read, $request_id ) );
+        ( $more_to_come || ( $result = MongoDB::_Protocol::parse_reply( $link->read, $request_id ) ) );
     };
     if ( my $err = $@ ) {
         $self->_update_session_connection_error( $err );
@@ -204,6 +210,16 @@ sub _send_write_command {
         die $err;
     }
 
+    if ($more_to_come) {
+        $self->publish_command_reply( { ok => 1 } )
+          if $self->monitoring_callback;
+
+        return MongoDB::UnacknowledgedResult->_new(
+            write_errors         => [],
+            write_concern_errors => [],
+        );
+    }
+
     $self->publish_command_reply( $result->{docs} )
       if $self->monitoring_callback;
 
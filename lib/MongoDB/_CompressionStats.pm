@@ -0,0 +1,94 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::_CompressionStats;
+
+# Tracks how well messages compress, per command name, so that wire
+# compression can be skipped for kinds of messages that don't shrink, like
+# inserts of already compressed GridFS chunks.  A kind that was switched off
+# is still compressed once every probe_interval messages, so it is switched
+# back on if its payloads change.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use MongoDB::_Types qw(
+    NonNegNum
+);
+use Types::Standard qw(
+    HashRef
+);
+use namespace::clean;
+
+# compressed size over original size above which compression is skipped
+has max_ratio => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => 0.9,
+);
+
+has probe_interval => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => 16,
+);
+
+# weight of the latest message in the moving average of the ratio
+has alpha => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => 0.2,
+);
+
+# kind => { ratio => average, skipped => count }
+has _stats => (
+    is       => 'ro',
+    isa      => HashRef,
+    init_arg => undef,
+    default  => sub { {} },
+);
+
+sub should_compress {
+    my ( $self, $kind ) = @_;
+    my $stats = $self->{_stats}{$kind}
+      or return 1;
+    return 1 if $stats->{ratio} <= $self->{max_ratio};
+    return ++$stats->{skipped} % $self->{probe_interval} == 0;
+}
+
+sub observe {
+    my ( $self, $kind, $before, $after ) = @_;
+    return unless $before;
+    my $ratio = $after / $before;
+    if ( my $stats = $self->{_stats}{$kind} ) {
+        $stats->{ratio} = $self->{alpha} * $ratio + ( 1 - $self->{alpha} ) * $stats->{ratio};
+    }
+    else {
+        $self->{_stats}{$kind} = { ratio => $ratio, skipped => 0 };
+    }
+    return;
+}
+
+sub ratio {
+    my ( $self, $kind ) = @_;
+    my $stats = $self->{_stats}{$kind};
+    return $stats ? $stats->{ratio} : undef;
+}
+
+1;
+
+# vim: ts=4 sts=4 sw=4 et:
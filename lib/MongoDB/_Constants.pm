@@ -33,10 +33,14 @@ BEGIN {
         CURSOR_ZERO                  => "\0" x 8,
         EPOCH                        => 0,
         HAS_INT64                    => $Config{use64bitint},
+        HEDGE_MAX_SAMPLES            => 100,
+        HEDGE_MIN_SAMPLES            => 20,
+        HEDGE_PERCENTILE             => 95,
         IDLE_WRITE_PERIOD_SEC        => 10,
         MAX_BSON_OBJECT_SIZE         => 4_194_304,
         MAX_GRIDFS_BATCH_SIZE        => 16_777_216,                 # 16MiB
         MAX_BSON_WIRE_SIZE           => 16_793_600,                 # 16MiB + 16KiB
+        MAX_COMMAND_OVERHEAD         => 16_384,                     # 16KiB
         MAX_WIRE_VERSION             => 8,
         MAX_WRITE_BATCH_SIZE         => 1000,
         MIN_HEARTBEAT_FREQUENCY_SEC  => .5,
@@ -47,6 +51,7 @@ BEGIN {
         RESCAN_SRV_FREQUENCY_SEC      => $ENV{TEST_MONGO_RESCAN_SRV_FREQUENCY_SEC} || 60,
         NO_JOURNAL_RE                => qr/^journaling not enabled/,
         NO_REPLICATION_RE          => qr/^no replication has been enabled/,
+        OP_LATENCY_DECAY_SEC       => 10,
         P_INT32                    => $] lt '5.010' ? 'l' : 'l<',
         SMALLEST_MAX_STALENESS_SEC => 90,
         WITH_ASSERTS               => $ENV{PERL_MONGO_WITH_ASSERTS},
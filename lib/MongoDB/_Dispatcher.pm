@@ -24,12 +24,19 @@ our $VERSION = 'v2.2.3';
 
 use Moo;
 use MongoDB::_Constants;
+use MongoDB::Op::_Command;
 use MongoDB::_Types qw(
     Boolish
+    NonNegNum
 );
 use Carp;
+use List::Util qw/first/;
+use Time::HiRes qw/time/;
 use Types::Standard qw(
+    ConsumerOf
+    HashRef
     InstanceOf
+    Maybe
 );
 use Safe::Isa;
 
@@ -53,6 +60,42 @@ has retry_reads => (
     isa      => Boolish,
 );
 
+# event loop adaptor for send_command_async
+has io_backend => (
+    is  => 'ro',
+    isa => Maybe [ ConsumerOf ['MongoDB::Role::_IOBackend'] ],
+);
+
+# client timeout_ms in seconds; zero for no operation deadline
+has timeout_sec => (
+    is      => 'ro',
+    default => 0,
+    isa     => NonNegNum,
+);
+
+# server address => times of recent hedged reads, oldest first
+has _read_times => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { {} },
+    isa      => HashRef,
+);
+
+# With timeout_ms set, each op sent runs under a deadline that server
+# selection, socket reads and writes, retries and maxTimeMS all draw from.
+# An op sent while another is under way shares the outer deadline.
+sub _op_deadline {
+    my ($self) = @_;
+    return $self->{topology}{_deadline}
+      // ( $self->{timeout_sec} ? time + $self->{timeout_sec} : undef );
+}
+
+sub _deadline_passed {
+    my ($self) = @_;
+    my $deadline = $self->{topology}{_deadline};
+    return defined $deadline && time >= $deadline;
+}
+
 # Reset session state if we're outside an active transaction, otherwise set
 # that this transaction actually has operations
 sub _maybe_update_session_state {
@@ -67,6 +110,7 @@ sub _maybe_update_session_state {
 # op dispatcher written in highly optimized style
 sub send_direct_op {
     my ( $self, $op, $address ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
     my ( $link, $result );
 
     $self->_maybe_update_session_state( $op );
@@ -81,13 +125,92 @@ sub send_direct_op {
                 $self->{topology}->mark_server_unknown( $link->server, $err );
                 $self->{topology}->mark_stale;
             }
+            $self->{topology}->check_in_link($link);
             # regardless of cleanup, rethrow the error
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
           }
       ),
+      $self->{topology}->check_in_link($link),
       return $result;
 }
 
+# Split version of send_direct_op for ops with start and finish methods:
+# start_direct_op sends the request and returns the link, which stays
+# checked out until finish_direct_op reads the reply on it.  Returns nothing
+# if the op cannot be split on the selected link; the caller should then
+# use send_direct_op.  A result with more_to_come means the server is
+# streaming further replies: the link stays checked out for more calls to
+# finish_direct_op, or for cancel_direct_op to abandon the stream.
+sub start_direct_op {
+    my ( $self, $op, $address ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
+    my ( $link, $started );
+
+    $self->_maybe_update_session_state( $op );
+
+    $link = $self->{topology}->get_specific_link( $address, $op );
+    eval { $started = $op->start($link); 1 }
+      or $self->_direct_op_failed( $link, $@ );
+
+    if ($started) {
+        # the link stays out while the caller works through earlier
+        # batches, so its time to check-in isn't the server's latency
+        $link->_clear_op_started;
+        return $link;
+    }
+
+    $self->{topology}->check_in_link($link);
+    return;
+}
+
+sub finish_direct_op {
+    my ( $self, $op, $link ) = @_;
+    my $result;
+
+    # each reply gets the full timeout from when it is asked for, however
+    # long the caller spent on earlier batches
+    my $deadline = $self->_op_deadline;
+    defined $deadline ? $link->_set_deadline($deadline) : $link->_clear_deadline;
+
+    eval { $result = $op->finish($link); 1 }
+      or $self->_direct_op_failed( $link, $@ );
+
+    $self->{topology}->check_in_link($link) unless $result->{more_to_come};
+    return $result;
+}
+
+# replies still on their way can't be skipped, so the link is closed
+sub cancel_direct_op {
+    my ( $self, $op, $link ) = @_;
+    $link->_close;
+    $self->{topology}->check_in_link($link);
+    return;
+}
+
+# leaves the reply to be read once it arrives, without waiting for it; see
+# MongoDB::_Topology/drain_link
+sub abandon_direct_op {
+    my ( $self, $op, $link ) = @_;
+    $self->{topology}->drain_link( $link, $op->abandon($link), $op->session );
+    return;
+}
+
+sub _direct_op_failed {
+    my ( $self, $link, $err ) = @_;
+    $err = "caught error, but it was lost in eval unwind" unless length $err;
+    if ( $err->$_isa("MongoDB::ConnectionError") || $err->$_isa("MongoDB::NetworkTimeout") ) {
+        $self->{topology}->mark_server_unknown( $link->server, $err );
+    }
+    elsif ( $err->$_isa("MongoDB::NotMasterError") ) {
+        $self->{topology}->mark_server_unknown( $link->server, $err );
+        $self->{topology}->mark_stale;
+    }
+    $self->{topology}->check_in_link($link);
+    WITH_ASSERTS ? ( confess $err ) : ( die $err );
+}
+
+# links are checked out of the topology's pools and must be checked back in
+# once the op is done with them
 sub _retrieve_link_for {
     my ( $self, $op, $rw ) = @_;
     my $topology = $self->{'topology'};
@@ -110,6 +233,7 @@ sub _retrieve_link_for {
 # op dispatcher written in highly optimized style
 sub send_write_op {
     my ( $self, $op ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
     my ( $link, $result );
 
     $self->_maybe_update_session_state( $op );
@@ -133,6 +257,7 @@ BEGIN {
 
 sub send_retryable_write_op {
     my ( $self, $op, $force ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
     my ( $link, $result ) = ( $self->_retrieve_link_for( $op, 'w' ) );
 
     $self->_maybe_update_session_state( $op );
@@ -176,8 +301,9 @@ sub send_retryable_write_op {
             die $err;
         }
 
-        # If the error is not retryable, then drop out
-        unless ( $err->$_call_if_can('_is_retryable') ) {
+        # If the error is not retryable, or there is no time left to retry,
+        # then drop out
+        unless ( $err->$_call_if_can('_is_retryable') && !$self->_deadline_passed ) {
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
         }
 
@@ -188,6 +314,7 @@ sub send_retryable_write_op {
 
         # Rare chance that the new link is not retryable
         unless ( $retry_link->supports_retryWrites ) {
+            $self->{topology}->check_in_link($retry_link);
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
         }
 
@@ -217,29 +344,148 @@ sub _is_primary_stepdown {
     ) || $not_master;
 }
 
-# op dispatcher written in highly optimized style
+# Network errors make the link's server unknown; a stepdown also makes the
+# topology stale, so the next op rescans for a primary.
+sub _update_topology_for_error {
+    my ( $self, $link, $err ) = @_;
+    if ( $err->$_isa("MongoDB::ConnectionError") || $err->$_isa("MongoDB::NetworkTimeout") ) {
+        $self->{topology}->mark_server_unknown( $link->server, $err );
+    }
+    elsif ( $err->$_isa('MongoDB::Error') && $self->_is_primary_stepdown( $err, $link ) ) {
+        $self->{topology}->mark_server_unknown( $link->server, $err );
+        $self->{topology}->mark_stale;
+    }
+    return;
+}
+
+# op dispatcher written in highly optimized style; the link is checked
+# back in to its pool whether or not the op succeeds
 sub _try_op_for_link {
     my ( $self, $link, $op ) = @_;
     my $result;
     (
         eval { ($result) = $op->execute($link, $self->{topology}->type); 1 } or do {
             my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
-            if ( $err->$_isa("MongoDB::ConnectionError") || $err->$_isa("MongoDB::NetworkTimeout") ) {
-                $self->{topology}->mark_server_unknown( $link->server, $err );
-            }
-            elsif ( $self->_is_primary_stepdown($err, $link) ) {
-                $self->{topology}->mark_server_unknown( $link->server, $err );
-                $self->{topology}->mark_stale;
-            }
+            $self->_update_topology_for_error( $link, $err );
+            $self->{topology}->check_in_link($link);
             # normal die here instead of assert, which is used later
             die $err;
         }
     ),
+    $self->{topology}->check_in_link($link),
     return $result;
 }
 
+# Sends several independent commands over one link, paying a single round
+# trip for the batch.  The link is selected for the first op, so all ops must
+# be valid on that server.  Ops are not retried; returns a result or error
+# object for each op, in order.
+sub send_pipelined_ops {
+    my ( $self, $ops, $rw ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
+    my ( $link, @results );
+
+    $self->_maybe_update_session_state( $_ ) for @$ops;
+
+    ( $link = $self->_retrieve_link_for( $ops->[0], $rw || 'w' ) ), (
+        eval {
+            @results = MongoDB::Op::_Command->execute_pipelined( $link, $ops, $self->{topology}->type );
+            1;
+        } or do {
+            my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
+            $self->_update_topology_for_error( $link, $err );
+            $self->{topology}->check_in_link($link);
+            WITH_ASSERTS ? ( confess $err ) : ( die $err );
+        }
+      );
+
+    # errors in the results are those of single ops, so only a stepdown
+    # matters; the first one invalidates the server for the rest
+    if ( my $err = first { $_->$_isa('MongoDB::Error') && $self->_is_primary_stepdown( $_, $link ) } @results ) {
+        $self->_update_topology_for_error( $link, $err );
+    }
+    $self->{topology}->check_in_link($link);
+
+    return @results;
+}
+
+# Sends a command and returns immediately; the reply is read when the event
+# loop reports the link readable and $cb is called with either a result or
+# an error.  Each command in flight holds its own link from the pool.  Link
+# selection and the write itself still block, but both are short compared
+# to waiting for the server.  Ops are not retried.
+sub send_command_async {
+    my ( $self, $op, $rw, $cb ) = @_;
+    my $backend = $self->{io_backend}
+      or MongoDB::UsageError->throw("an io_backend is required for asynchronous operations");
+    my $topology = $self->{topology};
+    my ( $link, $request_id, $watcher, $timer );
+
+    my $finish = sub {
+        my ( $result, $err ) = @_;
+        undef $watcher;
+        undef $timer;
+        if ($link) {
+            $self->_update_topology_for_error( $link, $err ) if defined $err;
+            $topology->check_in_link($link);
+        }
+        $cb->( $result, $err );
+    };
+
+    $self->_maybe_update_session_state( $op );
+
+    eval {
+        $link = $self->_retrieve_link_for( $op, $rw || 'r' );
+        my ( $op_bson, $write_opt );
+        ( $op_bson, $request_id, $write_opt ) = $op->_prepare_message( $link, $topology->type );
+        eval { $link->write( $op_bson, $write_opt ); 1 } or do {
+            my $err = $@;
+            $op->_update_session_connection_error( $err );
+            $op->publish_command_exception($err) if $op->monitoring_callback;
+            die $err;
+        };
+        1;
+    } or do {
+        my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
+        $finish->( undef, $err );
+        return;
+    };
+
+    $watcher = $backend->watch_read(
+        $link->fh,
+        sub {
+            my $msg = eval { $link->read_available };
+            if ( my $err = $@ ) {
+                $op->_update_session_connection_error( $err );
+                $op->publish_command_exception($err) if $op->monitoring_callback;
+                return $finish->( undef, $err );
+            }
+            return unless defined $msg;
+            my $result = eval { $op->_handle_reply( $link, $msg, $request_id ) };
+            $finish->( $result, defined $result ? undef : $@ );
+        }
+    );
+
+    if ( my $timeout = $link->socket_timeout ) {
+        $timer = $backend->timer(
+            $timeout,
+            sub {
+                $link->_close;
+                my $err = MongoDB::NetworkTimeout->new(
+                    message => "Timed out while waiting for socket to become ready for reading\n" );
+                $op->_update_session_connection_error( $err );
+                $op->publish_command_exception($err) if $op->monitoring_callback;
+                $finish->( undef, $err );
+            }
+        );
+    }
+
+    return;
+}
+
 sub send_retryable_read_op {
     my ( $self, $op ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
     my $result;
 
     # Get transaction read preference if in a transaction.
@@ -258,7 +504,7 @@ sub send_retryable_read_op {
         || ! $self->retry_reads
         || ( defined $op->session && $op->session->_in_transaction_state( TXN_STARTING, TXN_IN_PROGRESS ))
     ) {
-        eval { ($result) = $self->_try_op_for_link( $link, $op ); 1 } or do {
+        eval { ($result) = $self->_try_read_op_for_link( $link, $op ); 1 } or do {
             my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
         };
@@ -269,11 +515,12 @@ sub send_retryable_read_op {
 
     $op->retryable_read( 1 );
     # attempt the op the first time
-    eval { ($result) = $self->_try_op_for_link( $link, $op ); 1 } or do {
+    eval { ($result) = $self->_try_read_op_for_link( $link, $op ); 1 } or do {
         my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
 
-        # If the error is not retryable, then drop out
-        unless ( $err->$_call_if_can('_is_retryable') ) {
+        # If the error is not retryable, or there is no time left to retry,
+        # then drop out
+        unless ( $err->$_call_if_can('_is_retryable') && !$self->_deadline_passed ) {
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
         }
 
@@ -281,6 +528,7 @@ sub send_retryable_read_op {
 
         # Rare chance that the new link is not retryable
         unless ( $retry_link->supports_retryReads ) {
+            $self->{topology}->check_in_link($retry_link);
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
         }
 
@@ -299,6 +547,7 @@ sub send_retryable_read_op {
 # op dispatcher written in highly optimized style
 sub send_read_op {
     my ( $self, $op ) = @_;
+    local $self->{topology}{_deadline} = $self->_op_deadline;
     my ( $link, $type, $result );
 
     # Get transaction read preference if in a transaction.
@@ -311,8 +560,11 @@ sub send_read_op {
 
     $self->_maybe_update_session_state( $op );
 
-    ( $link = $self->_retrieve_link_for( $op, 'r' ) ),
-      ( $type = $self->{topology}->type ), (
+    $link = $self->_retrieve_link_for( $op, 'r' );
+    return $self->_try_hedged_read( $link, $op )
+      if $self->_can_hedge($op);
+
+    ( $type = $self->{topology}->type ), (
         eval { ($result) = $op->execute( $link, $type ); 1 } or do {
             my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
             if ( $err->$_isa("MongoDB::ConnectionError") || $err->$_isa("MongoDB::NetworkTimeout") ) {
@@ -322,11 +574,163 @@ sub send_read_op {
                 $self->{topology}->mark_server_unknown( $link->server, $err );
                 $self->{topology}->mark_stale;
             }
+            $self->{topology}->check_in_link($link);
             # regardless of cleanup, rethrow the error
             WITH_ASSERTS ? ( confess $err ) : ( die $err );
           }
       ),
+      $self->{topology}->check_in_link($link),
       return $result;
 }
 
+sub _try_read_op_for_link {
+    my ( $self, $link, $op ) = @_;
+    return $self->_can_hedge($op)
+      ? $self->_try_hedged_read( $link, $op )
+      : $self->_try_op_for_link( $link, $op );
+}
+
+# The driver hedges reads itself only for replica sets; mongos gets the
+# hedge option with the read preference.
+sub _can_hedge {
+    my ( $self, $op ) = @_;
+    return unless $op->can('is_hedgeable') && $op->is_hedgeable;
+    my $read_pref = $op->read_preference;
+    return
+         $read_pref
+      && $read_pref->is_hedged
+      && $self->{topology}->type =~ /^ReplicaSet/
+      && !( $op->session && $op->session->_active_transaction );
+}
+
+# Sends the read to $link and, if no reply came within the hedge delay, to a
+# second suitable server as well; the first successful reply wins.  The
+# delay is a high percentile of recent read times from the first server, so
+# until enough of those are known reads are only timed.  The request left
+# unanswered is handed to the topology to drain, which kills any cursor it
+# opened.  As with _try_op_for_link, links are checked back in whether or
+# not the op succeeds.
+sub _try_hedged_read {
+    my ( $self, $link, $op ) = @_;
+    my $topology = $self->{topology};
+    my $type     = $topology->type;
+    my $start    = time;
+
+    my $started = eval { $op->start( $link, $type ) };
+    if ( !defined $started ) {
+        my $err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
+        $self->_hedged_link_failed( $link, $err );
+        die $err;
+    }
+    return $self->_try_op_for_link( $link, $op ) unless $started;
+
+    my $delay    = $self->_hedge_delay( $link->address );
+    my $hedge_at = defined $delay ? $start + $delay : undef;
+    my $timeout  = $link->socket_timeout;
+    my $deadline = defined $timeout && $timeout >= 0 ? $start + $timeout : undef;
+    $deadline = $link->deadline
+      if defined $link->deadline && ( !defined $deadline || $link->deadline < $deadline );
+    my %sent_at  = ( $link->address => $start );
+    my @waiting  = ($link);
+    my ( $result, $winner, $err );
+
+    while ( @waiting && !$result ) {
+        # a lone request without a hedge to come is read like any other
+        my @ready =
+            $hedge_at     ? $topology->_wait_readable( \@waiting, $hedge_at )
+          : @waiting == 1 ? @waiting
+          :                 $topology->_wait_readable( \@waiting, $deadline );
+
+        if ( !@ready && $hedge_at ) {
+            undef $hedge_at;
+            if ( my $hedge = $self->_start_hedge( $op, $link->address ) ) {
+                $sent_at{ $hedge->address } = time;
+                push @waiting, $hedge;
+            }
+            next;
+        }
+
+        if ( !@ready ) {
+            $err ||=
+              defined $link->deadline && time >= $link->deadline
+              ? MongoDB::ExecutionTimeout->new( message =>
+                  "Operation exceeded its timeout while waiting for socket to become ready for reading\n" )
+              : MongoDB::NetworkTimeout->new(
+                message => "Timed out while waiting for socket to become ready for reading\n" );
+            for my $late (@waiting) {
+                $op->abandon($late);
+                $late->_close;
+                $self->_hedged_link_failed( $late, $err );
+            }
+            @waiting = ();
+            last;
+        }
+
+        for my $ready (@ready) {
+            @waiting = grep { $_ != $ready } @waiting;
+            my $res = eval { $op->finish($ready) };
+            if ( defined $res ) {
+                ( $result, $winner ) = ( $res, $ready );
+                last;
+            }
+            my $read_err = length($@) ? $@ : "caught error, but it was lost in eval unwind";
+            $err ||= $read_err;
+            $self->_hedged_link_failed( $ready, $read_err );
+        }
+    }
+
+    $topology->drain_link( $_, $op->abandon($_), $op->session ) for @waiting;
+
+    if ($result) {
+        $self->_add_read_time( $winner->address, time - $sent_at{ $winner->address } );
+        # a first server that lost took at least this long
+        $self->_add_read_time( $link->address, time - $start ) if $winner != $link;
+        $topology->check_in_link($winner);
+        return $result;
+    }
+
+    die $err;
+}
+
+sub _start_hedge {
+    my ( $self, $op, $address ) = @_;
+    my $topology = $self->{topology};
+    my $hedge    = $topology->get_hedge_link( $op, $address )
+      or return;
+
+    my $started = eval { $op->start( $hedge, $topology->type ) };
+    return $hedge if $started;
+
+    if ( defined $started ) {
+        $topology->check_in_link($hedge);
+    }
+    else {
+        $self->_hedged_link_failed( $hedge, $@ );
+    }
+    return;
+}
+
+sub _hedged_link_failed {
+    my ( $self, $link, $err ) = @_;
+    $self->_update_topology_for_error( $link, $err );
+    $self->{topology}->check_in_link($link);
+    return;
+}
+
+sub _hedge_delay {
+    my ( $self, $address ) = @_;
+    my $times = $self->{_read_times}{$address};
+    return unless $times && @$times >= HEDGE_MIN_SAMPLES;
+    my @sorted = sort { $a <=> $b } @$times;
+    return $sorted[ int( $#sorted * HEDGE_PERCENTILE / 100 ) ];
+}
+
+sub _add_read_time {
+    my ( $self, $address, $elapsed ) = @_;
+    my $times = $self->{_read_times}{$address} ||= [];
+    push @$times, $elapsed;
+    shift @$times if @$times > HEDGE_MAX_SAMPLES;
+    return;
+}
+
 1;
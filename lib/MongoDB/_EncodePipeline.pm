@@ -0,0 +1,215 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::_EncodePipeline;
+
+# Encodes documents to insert in forked worker processes, so that a bulk
+# write can send one batch while the following ones are being encoded.
+#
+# The documents are cut into chunks, which worker N encodes in turn: chunks
+# N, N + workers, N + 2 * workers and so on.  Each chunk is encoded in full
+# before it is written to the worker's pipe, so while the parent reads one
+# worker's chunk the others are already encoding their next ones.  Workers
+# see the documents through fork, so only the encoded bytes cross a pipe.
+#
+# A record is two int32 lengths, a document holding just the _id, and the
+# encoded document.  A record with an empty document marks one that failed
+# to encode; the parent encodes it again itself to throw the error.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use MongoDB::Error;
+use MongoDB::_Constants;
+use MongoDB::_Platform;
+use MongoDB::_Types qw(
+    NonNegNum
+);
+use Types::Standard qw(
+    ArrayRef
+);
+use namespace::clean;
+
+has bson_codec => (
+    is       => 'ro',
+    required => 1,
+);
+
+with 'MongoDB::Role::_InsertPreEncoder';
+
+has docs => (
+    is       => 'ro',
+    isa      => ArrayRef,
+    required => 1,
+);
+
+has workers => (
+    is       => 'ro',
+    isa      => NonNegNum,
+    required => 1,
+);
+
+has max_bson_size => (
+    is       => 'ro',
+    isa      => NonNegNum,
+    required => 1,
+);
+
+has chunk_size => (
+    is      => 'ro',
+    isa     => NonNegNum,
+    default => MAX_WRITE_BATCH_SIZE,
+);
+
+# [ fh, pid ] for each worker
+has _workers => (
+    is       => 'ro',
+    isa      => ArrayRef,
+    init_arg => undef,
+    default  => sub { [] },
+);
+
+# encoded documents read but not yet taken
+has _ready => (
+    is       => 'ro',
+    isa      => ArrayRef,
+    init_arg => undef,
+    default  => sub { [] },
+);
+
+# index of the next document to read
+has _next_doc => (
+    is       => 'rw',
+    init_arg => undef,
+    default  => 0,
+);
+
+sub start {
+    my ($self) = @_;
+    my $chunks = int( ( @{ $self->docs } + $self->chunk_size - 1 ) / $self->chunk_size );
+    my $workers = $self->workers < $chunks ? $self->workers : $chunks;
+
+    MongoDB::_Platform::flush_std_handles();
+
+    for my $w ( 0 .. $workers - 1 ) {
+        pipe( my $reader, my $writer )
+          or MongoDB::InternalError->throw("Couldn't create encoding pipe: $!");
+        my $pid = fork;
+        MongoDB::InternalError->throw("Couldn't fork encoding worker: $!")
+          unless defined $pid;
+        if ( !$pid ) {
+            close $reader;
+            close $_->[0] for @{ $self->_workers };
+            binmode $writer;
+            for ( my $c = $w ; $c < $chunks ; $c += $workers ) {
+                print {$writer} $self->_encode_chunk($c) or last;
+            }
+            # a short or missing stream tells the parent the worker failed
+            close $writer;
+            MongoDB::_Platform::exit_forked_worker(0);
+        }
+        close $writer;
+        binmode $reader;
+        push @{ $self->_workers }, [ $reader, $pid ];
+    }
+
+    return $self;
+}
+
+sub _encode_chunk {
+    my ( $self, $chunk ) = @_;
+    my ( $docs, $codec ) = ( $self->docs, $self->bson_codec );
+    my $from = $chunk * $self->chunk_size;
+    my $to   = $from + $self->chunk_size - 1;
+    $to = $#$docs if $to > $#$docs;
+
+    my $out = '';
+    for my $doc ( @{$docs}[ $from .. $to ] ) {
+        my $raw = eval { $self->_pre_encode_insert( $self->max_bson_size, $doc, '.' ) };
+        if ( !$raw ) {
+            $out .= pack( P_INT32 . P_INT32, 0, 0 );
+            next;
+        }
+        my $id = $codec->encode_one( [ _id => $raw->{metadata}{_id} ] );
+        $out .= pack( P_INT32 . P_INT32, length $id, length $raw->{bson} ) . $id . $raw->{bson};
+    }
+    return $out;
+}
+
+# Returns the next $n encoded documents, in the order of docs.
+sub take {
+    my ( $self, $n ) = @_;
+    my $ready = $self->_ready;
+    $self->_read_chunk while @$ready < $n && $self->_next_doc < @{ $self->docs };
+    return splice( @$ready, 0, $n );
+}
+
+sub _read_chunk {
+    my ($self) = @_;
+    my $docs  = $self->docs;
+    my $from  = $self->_next_doc;
+    my $chunk = int( $from / $self->chunk_size );
+    my $to    = $from + $self->chunk_size - 1;
+    $to = $#$docs if $to > $#$docs;
+
+    my $fh = $self->_workers->[ $chunk % @{ $self->_workers } ][0];
+    for my $i ( $from .. $to ) {
+        my ( $id_len, $len ) = unpack( P_INT32 . P_INT32, _read( $fh, 8 ) );
+        if ( !$len ) {
+            # throws the error the worker caught
+            push @{ $self->_ready },
+              $self->_pre_encode_insert( $self->max_bson_size, $docs->[$i], '.' );
+            next;
+        }
+        my $id = $self->bson_codec->decode_one( _read( $fh, $id_len ) )->{_id};
+        push @{ $self->_ready },
+          bless( { bson => _read( $fh, $len ), metadata => { _id => $id } }, "BSON::Raw" );
+    }
+    $self->_next_doc( $to + 1 );
+
+    return;
+}
+
+sub _read {
+    my ( $fh, $len ) = @_;
+    my $buf = '';
+    while ( length $buf < $len ) {
+        my $got = sysread( $fh, $buf, $len - length $buf, length $buf );
+        MongoDB::InternalError->throw("encoding worker stopped early")
+          unless $got;
+    }
+    return $buf;
+}
+
+sub finish {
+    my ($self) = @_;
+    my $workers = $self->_workers;
+    for my $w (@$workers) {
+        my ( $fh, $pid ) = @$w;
+        close $fh;
+        kill 'TERM', $pid;
+        waitpid( $pid, 0 );
+    }
+    @$workers = ();
+    return;
+}
+
+sub DEMOLISH { $_[0]->finish }
+
+1;
+
+# vim: ts=4 sts=4 sw=4 et:
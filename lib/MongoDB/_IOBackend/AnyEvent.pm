@@ -0,0 +1,47 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+use strict;
+use warnings;
+package MongoDB::_IOBackend::AnyEvent;
+
+# Runs asynchronous operations on the AnyEvent event loop.  AnyEvent can in
+# turn run on top of EV, IO::Async, POE and others, so this also serves
+# applications built on those.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use MongoDB::Error;
+use namespace::clean;
+
+with 'MongoDB::Role::_IOBackend';
+
+sub BUILD {
+    MongoDB::UsageError->throw(qq/AnyEvent must be installed to use the AnyEvent I\/O backend\n/)
+      unless eval { require AnyEvent; 1 };
+    return;
+}
+
+sub watch_read {
+    my ( $self, $fh, $cb ) = @_;
+    return AnyEvent->io( fh => $fh, poll => 'r', cb => $cb );
+}
+
+sub timer {
+    my ( $self, $after, $cb ) = @_;
+    return AnyEvent->timer( after => $after, cb => $cb );
+}
+
+1;
@@ -0,0 +1,55 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+use strict;
+use warnings;
+package MongoDB::_IOBackend::Mojo;
+
+# Runs asynchronous operations on the Mojo::IOLoop singleton.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use MongoDB::Error;
+use namespace::clean;
+
+with 'MongoDB::Role::_IOBackend';
+
+sub BUILD {
+    MongoDB::UsageError->throw(qq/Mojolicious must be installed to use the Mojo I\/O backend\n/)
+      unless eval { require Mojo::IOLoop; 1 };
+    return;
+}
+
+sub watch_read {
+    my ( $self, $fh, $cb ) = @_;
+    my $reactor = Mojo::IOLoop->singleton->reactor;
+    $reactor->io( $fh => sub { $cb->() } )->watch( $fh, 1, 0 );
+    return MongoDB::_IOBackend::Mojo::_Guard->_new( sub { $reactor->remove($fh) } );
+}
+
+sub timer {
+    my ( $self, $after, $cb ) = @_;
+    my $id = Mojo::IOLoop->timer( $after => sub { $cb->() } );
+    return MongoDB::_IOBackend::Mojo::_Guard->_new( sub { Mojo::IOLoop->remove($id) } );
+}
+
+# Mojo watchers are removed by ID rather than by scope, so wrap them
+package MongoDB::_IOBackend::Mojo::_Guard;
+
+sub _new { my ( $class, $cancel ) = @_; return bless \$cancel, $class }
+
+sub DESTROY { ${ $_[0] }->() }
+
+1;
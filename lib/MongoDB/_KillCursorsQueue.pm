@@ -0,0 +1,124 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::_KillCursorsQueue;
+
+# Collects the IDs of cursors abandoned by their owners, so they can be
+# killed in batches instead of with a round trip each as the cursors are
+# destroyed.  IDs are grouped by server address, namespace and session; the
+# IDs for one namespace and session are merged into the cursor_ids of a
+# single killCursors op, which keeps the session the cursors were opened
+# under.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use Scalar::Util qw/refaddr/;
+use Time::HiRes qw/time/;
+use MongoDB::_Types qw(
+    NonNegNum
+);
+use Types::Standard qw(
+    HashRef
+);
+use namespace::clean;
+
+# a server's IDs are due once this many are queued...
+has max_cursors => (
+    is      => 'ro',
+    default => 100,
+    isa     => NonNegNum,
+);
+
+# ...or once the oldest has waited this long
+has max_age_sec => (
+    is      => 'ro',
+    default => 5,
+    isa     => NonNegNum,
+);
+
+# address => { since => time, count => N, ops => { namespace and session => op } }
+has _queue => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { {} },
+    isa      => HashRef,
+);
+
+# Queues the cursor IDs of a MongoDB::Op::_KillCursors op for $address.
+sub add {
+    my ( $self, $address, $op ) = @_;
+    my $entry = $self->{_queue}{$address} ||= { since => time, count => 0, ops => {} };
+    my $key = join "\0", $op->full_name, $op->session ? refaddr $op->session : '';
+    if ( my $queued = $entry->{ops}{$key} ) {
+        push @{ $queued->cursor_ids }, @{ $op->cursor_ids };
+    }
+    else {
+        $entry->{ops}{$key} = $op;
+    }
+    $entry->{count} += @{ $op->cursor_ids };
+    return;
+}
+
+sub count {
+    my ( $self, $address ) = @_;
+    my $entry = $self->{_queue}{$address};
+    return $entry ? $entry->{count} : 0;
+}
+
+# Removes and returns the queued ops for $address, one per namespace and
+# session.
+sub take {
+    my ( $self, $address ) = @_;
+    my $entry = delete $self->{_queue}{$address}
+      or return;
+    return values %{ $entry->{ops} };
+}
+
+# Removes and returns [ address, op ] for each op queued under $session.
+sub take_session {
+    my ( $self, $session ) = @_;
+    my $queue = $self->{_queue};
+    my @taken;
+    for my $address ( keys %$queue ) {
+        my $entry = $queue->{$address};
+        for my $key ( keys %{ $entry->{ops} } ) {
+            my $op = $entry->{ops}{$key};
+            next unless $op->session && refaddr $op->session == refaddr $session;
+            delete $entry->{ops}{$key};
+            $entry->{count} -= @{ $op->cursor_ids };
+            push @taken, [ $address, $op ];
+        }
+        delete $queue->{$address} unless %{ $entry->{ops} };
+    }
+    return @taken;
+}
+
+# Returns the addresses whose IDs should be sent without waiting for
+# another operation on the server.
+sub due {
+    my ( $self, $now ) = @_;
+    my $queue = $self->{_queue};
+    my $oldest = $now - $self->{max_age_sec};
+    return grep {
+        $queue->{$_}{count} >= $self->{max_cursors} || $queue->{$_}{since} <= $oldest
+    } keys %$queue;
+}
+
+1;
+
+# vim: ts=4 sts=4 sw=4 et:
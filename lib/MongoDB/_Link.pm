@@ -26,10 +26,10 @@ use version;
 our $VERSION = 'v2.2.3';
 
 use Moo;
-use Errno qw[EINTR EPIPE];
+use Errno qw[EINTR EPIPE EAGAIN EWOULDBLOCK EINPROGRESS EALREADY];
 use IO::Socket qw[SOCK_STREAM];
 use Scalar::Util qw/refaddr/;
-use Socket qw/SOL_SOCKET SO_KEEPALIVE SO_RCVBUF IPPROTO_TCP TCP_NODELAY AF_INET/;
+use Socket qw/SOL_SOCKET SO_ERROR SO_KEEPALIVE SO_RCVBUF IPPROTO_TCP TCP_NODELAY AF_INET/;
 use Time::HiRes qw/time/;
 use MongoDB::Error;
 use MongoDB::_Constants;
@@ -241,8 +241,14 @@ has supports_aggregate_out_read_concern => (
     isa => Boolish,
 );
 
+has supports_exhaust_allowed => (
+    is => 'rwp',
+    init_arg => undef,
+    isa => Boolish,
+);
+
 my @connection_state_fields = qw(
-    fh connected rcvbuf last_used fdset is_ssl
+    fh connected rcvbuf last_used fdset is_ssl pid
 );
 
 for my $f ( @connection_state_fields ) {
@@ -253,6 +259,31 @@ for my $f ( @connection_state_fields ) {
     );
 }
 
+# pool generation this link belongs to; set by MongoDB::_Pool
+has generation => (
+    is => 'rwp',
+    init_arg => undef,
+    default => 0,
+    isa => NonNegNum,
+);
+
+# absolute time by which the operation the link is checked out for must be
+# done, if the client has a timeout_ms; set by MongoDB::_Topology
+has deadline => (
+    is => 'rwp',
+    init_arg => undef,
+    clearer => '_clear_deadline',
+);
+
+# when the operation the link is checked out for started; set by
+# MongoDB::_Topology to time operations per server, and cleared for split
+# direct ops, which hold the link between batches
+has op_started => (
+    is => 'rwp',
+    init_arg => undef,
+    clearer => '_clear_op_started',
+);
+
 around BUILDARGS => sub {
     my $orig = shift;
     my $class = shift;
@@ -270,6 +301,62 @@ sub connect {
     @_ == 1 || MongoDB::UsageError->throw( q/Usage: $handle->connect()/ . "\n" );
     my ($self) = @_;
 
+    my $fh = $self->_new_socket( Timeout => $self->connect_timeout >= 0 ? $self->connect_timeout : undef );
+
+    return $self->_init_socket($fh);
+}
+
+# Begins a non-blocking connection, so several can be in progress at once.
+# Wait for the fdset to become writable, then call finish_connect until it
+# returns true.
+sub start_connect {
+    my ($self) = @_;
+
+    my $fh = $self->_new_socket( Blocking => 0 );
+    $self->_set_fh($fh);
+    $self->_set_fdset_for($fh);
+
+    return $self;
+}
+
+# Returns true once the connection started by start_connect is established
+# and false while it is still in progress; throws if it failed.
+sub finish_connect {
+    my ($self) = @_;
+    my $fh = $self->fh
+      or MongoDB::NetworkError->throw(qq/Could not connect to '@{[$self->address]}': not started\n/);
+
+    my $err;
+    if ( $fh->isa('IO::Socket::IP') ) {
+        # IO::Socket::IP moves on to the next address on failure, which may
+        # replace the underlying file descriptor
+        unless ( $fh->connect ) {
+            if ( $! == EINPROGRESS || $! == EALREADY || $! == EWOULDBLOCK ) {
+                $self->_set_fdset_for($fh);
+                return 0;
+            }
+            $err = "$!";
+        }
+    }
+    elsif ( my $errno = $fh->getsockopt( SOL_SOCKET, SO_ERROR ) ) {
+        local $! = $errno;
+        $err = "$!";
+    }
+
+    if ($err) {
+        $self->_close;
+        MongoDB::NetworkError->throw(qq/Could not connect to '@{[$self->address]}': $err\n/);
+    }
+
+    $fh->blocking(1);
+    $self->_clear_fh;
+    $self->_init_socket($fh);
+    return 1;
+}
+
+sub _new_socket {
+    my ( $self, @args ) = @_;
+
     if ( $self->with_ssl ) {
         $self->_assert_ssl;
         # XXX possibly make SOCKET_CLASS an instance variable and set it here to IO::Socket::SSL
@@ -289,11 +376,30 @@ sub connect {
         ( lc($host) eq 'localhost' ? ( Family => AF_INET ) : () ),
         Proto    => 'tcp',
         Type     => SOCK_STREAM,
-        Timeout  => $self->connect_timeout >= 0 ? $self->connect_timeout : undef,
+        @args,
       )
       or
       MongoDB::NetworkError->throw(qq/Could not connect to '@{[$self->address]}': $@\n/);
 
+    return $fh;
+}
+
+sub _set_fdset_for {
+    my ( $self, $fh ) = @_;
+    my $fd = fileno $fh;
+    unless ( defined $fd && $fd >= 0 ) {
+        $self->_close;
+        MongoDB::InternalError->throw(qq/select(2): 'Bad file descriptor'\n/);
+    }
+    vec( my $fdset = '', $fd, 1 ) = 1;
+    $self->_set_fdset( $fdset );
+    return;
+}
+
+sub _init_socket {
+    my ( $self, $fh ) = @_;
+    my ($host) = split /:/, $self->address;
+
     unless ( binmode($fh) ) {
         undef $fh;
         MongoDB::InternalError->throw(qq/Could not binmode() socket: '$!'\n/);
@@ -311,14 +417,9 @@ sub connect {
 
     $self->_set_fh($fh);
     $self->_set_connected(1);
+    $self->_set_pid($$);
 
-    my $fd = fileno $fh;
-    unless ( defined $fd && $fd >= 0 ) {
-        $self->_close;
-        MongoDB::InternalError->throw(qq/select(2): 'Bad file descriptor'\n/);
-    }
-    vec( my $fdset = '', $fd, 1 ) = 1;
-    $self->_set_fdset( $fdset );
+    $self->_set_fdset_for($fh);
 
     $self->start_ssl($host) if $self->with_ssl;
 
@@ -383,6 +484,7 @@ sub set_metadata {
     }
     if ( $self->accepts_wire_version(8) ) {
         $self->_set_supports_aggregate_out_read_concern(1);
+        $self->_set_supports_exhaust_allowed(1);
     }
 
     return;
@@ -441,9 +543,17 @@ sub close {
 sub _close {
     my ($self) = @_;
     $self->_clear_connected;
+    delete @{$self}{qw/_read_ahead _reply_buffer/};
     my $ok = 1;
-    if ( $self->fh ) {
-        $ok = CORE::close( $self->fh );
+    if ( my $fh = $self->fh ) {
+        # after a fork the connection is still the parent's, so only this
+        # process's descriptor is closed, without a TLS close_notify
+        if ( $self->{pid} && $self->{pid} != $$ && $fh->isa('IO::Socket::SSL') ) {
+            $fh->close( SSL_no_shutdown => 1 );
+        }
+        else {
+            $ok = CORE::close($fh);
+        }
         $self->_clear_fh;
     }
     return $ok;
@@ -455,32 +565,78 @@ sub is_connected {
 }
 
 sub write {
+    my ( $self, $buf, $write_opt ) = @_;
+    return $self->_write_buffer( $self->_prepare_write( $buf, $write_opt ) );
+}
+
+# Writes several messages back-to-back without waiting for replies; each
+# message is compressed and size checked on its own.
+sub write_many {
+    my ( $self, $bufs, $write_opts ) = @_;
+    return $self->_write_buffer(
+        join( '', map { $self->_prepare_write( $bufs->[$_], $write_opts->[$_] ) } 0 .. $#$bufs )
+    );
+}
+
+sub _prepare_write {
     my ( $self, $buf, $write_opt ) = @_;
     $write_opt ||= {};
 
-    if (
-        !$write_opt->{disable_compression}
-        && $self->server
-        && $self->server->compressor
-    ) {
-        $buf = MongoDB::_Protocol::compress(
-            $buf,
-            $self->server->compressor,
-        );
+    my $compressor =
+      !$write_opt->{disable_compression} && $self->server && $self->server->compressor;
+    if ( $compressor && length($buf) >= ( $compressor->{min_bytes} || 0 ) ) {
+        my $stats = $compressor->{stats};
+        my $kind  = $write_opt->{command_name} || '';
+        if ( !$stats || $stats->should_compress($kind) ) {
+            my $compressed = MongoDB::_Protocol::compress( $buf, $compressor );
+            $stats->observe( $kind, length $buf, length $compressed ) if $stats;
+            # the server takes either, so send whichever is smaller
+            $buf = $compressed if length $compressed < length $buf;
+        }
     }
 
-    my ( $len, $off, $pending, $nfound, $r ) = ( length($buf), 0 );
-
+    my $len = length($buf);
     MongoDB::ProtocolError->throw(
         qq/Message of size $len exceeds maximum of / . $self->{max_message_size_bytes} )
       if $len > $self->max_message_size_bytes;
 
+    return $buf;
+}
+
+# the socket timeout, cut short by the deadline of the current operation
+sub _io_timeout {
+    my ($self) = @_;
+    my $timeout = $self->{socket_timeout};
+    return $timeout unless defined $self->{deadline};
+    my $remaining = $self->{deadline} - time;
+    $remaining = 0 if $remaining < 0;
+    return defined $timeout && $timeout < $remaining ? $timeout : $remaining;
+}
+
+# The link is left mid-message, so it is closed either way.  Running out of
+# operation time says nothing about the server, so it is thrown as an
+# execution timeout, which the dispatcher doesn't count against the server.
+sub _throw_timeout {
+    my ( $self, $what ) = @_;
+    $self->_close;
+    MongoDB::ExecutionTimeout->throw(
+        qq/Operation exceeded its timeout while waiting for socket to become ready for $what\n/)
+      if defined $self->{deadline} && time >= $self->{deadline};
+    MongoDB::NetworkTimeout->throw(
+        qq/Timed out while waiting for socket to become ready for $what\n/);
+}
+
+sub _write_buffer {
+    my ( $self, $buf ) = @_;
+
+    my ( $len, $off, $pending, $nfound, $r ) = ( length($buf), 0 );
+
     local $SIG{PIPE} = 'IGNORE';
 
     while () {
 
         # do timeout
-        ( $pending, $nfound ) = ( $self->socket_timeout, 0 );
+        ( $pending, $nfound ) = ( $self->_io_timeout, 0 );
         TIMEOUT: while () {
             if ( -1 == ( $nfound = select( undef, $self->fdset, undef, $pending ) ) ) {
                 unless ( $! == EINTR ) {
@@ -495,11 +651,7 @@ sub write {
             }
             last TIMEOUT;
         }
-        unless ($nfound) {
-            $self->_close;
-            MongoDB::NetworkTimeout->throw(
-                qq/Timed out while waiting for socket to become ready for writing\n/);
-        }
+        $self->_throw_timeout('writing') unless $nfound;
 
         # do write
         if ( defined( $r = syswrite( $self->fh, $buf, $len, $off ) ) ) {
@@ -529,16 +681,48 @@ sub write {
     return;
 }
 
-sub read {
+# Scalar kept with the link for reading replies into, so consecutive replies
+# reuse one allocation; see _release_large_reply_buffer.
+sub reply_buffer { \$_[0]{_reply_buffer} }
+
+# Called as the link goes back to its pool: after an unusually large reply
+# the buffer is released rather than holding that memory for as long as the
+# link sits idle.
+sub _release_large_reply_buffer {
     my ($self) = @_;
+    undef $self->{_reply_buffer}
+      if defined $self->{_reply_buffer} && length $self->{_reply_buffer} > 4 * $self->rcvbuf;
+    return;
+}
+
+# Reads the next message.  With a scalar reference, the message is read into
+# that scalar instead and the reference is returned; reusing the same scalar
+# for every reply keeps its allocation between messages.
+sub read {
+    my ( $self, $buf ) = @_;
+    return $self->_read_into($buf) if $buf;
+    $self->_read_into( \my $msg );
+    return $msg;
+}
+
+sub _read_into {
+    my ( $self, $buf ) = @_;
 
-    # len of undef triggers first pass through loop
-    my ( $msg, $len, $pending, $nfound, $r ) = ( '', undef );
+    # start with anything read past the end of the previous message
+    $$buf = defined $self->{_read_ahead} ? delete $self->{_read_ahead} : '';
+    my ( $len, $want, $pending, $nfound, $r );
 
     while () {
+        if ( !defined $len && length($$buf) >= 4 ) {
+            $len = unpack( P_INT32, $$buf );
+            MongoDB::ProtocolError->throw(
+                qq/Server reply of size $len exceeds maximum of / . $self->{max_message_size_bytes} )
+              if $len > $self->max_message_size_bytes;
+        }
+        last if defined $len && length($$buf) >= $len;
 
         # do timeout
-        ( $pending, $nfound ) = ( $self->socket_timeout, 0 );
+        ( $pending, $nfound ) = ( $self->_io_timeout, 0 );
         TIMEOUT: while () {
             # no need to select if SSL and has pending data from a frame
             if ( $self->with_ssl ) {
@@ -559,14 +743,13 @@ sub read {
             }
             last TIMEOUT;
         }
-        unless ($nfound) {
-            $self->_close;
-            MongoDB::NetworkTimeout->throw(
-                q/Timed out while waiting for socket to become ready for reading/ . "\n" );
-        }
+        $self->_throw_timeout('reading') unless $nfound;
 
-        # read up to SO_RCVBUF if we can
-        if ( defined( $r = sysread( $self->fh, $msg, $self->rcvbuf, length $msg ) ) ) {
+        # until the length header is in, read up to SO_RCVBUF so small
+        # replies take a single read; after that, ask for exactly the rest
+        # of the message so the buffer is grown once to its final size
+        $want = defined $len ? $len - length($$buf) : $self->rcvbuf;
+        if ( defined( $r = sysread( $self->fh, $$buf, $want, length $$buf ) ) ) {
             # because select said we're ready to read, if we read 0 then
             # we got EOF before the full message
             if ( !$r ) {
@@ -585,20 +768,93 @@ sub read {
                 MongoDB::NetworkError->throw(qq/Could not read from socket: '$!'\n/);
             }
         }
+    }
 
-        if ( !defined $len ) {
-            next if length($msg) < 4;
-            $len = unpack( P_INT32, $msg );
-            MongoDB::ProtocolError->throw(
-                qq/Server reply of size $len exceeds maximum of / . $self->{max_message_size_bytes} )
-              if $len > $self->max_message_size_bytes;
+    # pipelined replies can arrive in the same read; keep the extra bytes
+    $self->{_read_ahead} = substr( $$buf, $len, length($$buf) - $len, '' )
+      if length($$buf) > $len;
+
+    $self->_set_last_used(time);
+
+    return $buf;
+}
+
+# For event loop backends: reads whatever the socket has without waiting
+# and returns the next complete message, or nothing if more data is needed.
+# Call again each time the socket becomes readable.
+sub read_available {
+    my ($self) = @_;
+    $self->{_read_ahead} = '' unless defined $self->{_read_ahead};
+    my $fh = $self->fh;
+
+    # a readable SSL socket may hold only part of a TLS record, which a
+    # blocking read would wait for the rest of
+    my $blocking = $self->with_ssl ? $fh->blocking(0) : undef;
+
+    my $err;
+    while () {
+        my $r = sysread( $fh, $self->{_read_ahead}, $self->rcvbuf, length $self->{_read_ahead} );
+        if ( !defined $r ) {
+            last
+              if $! == EINTR
+              || $! == EAGAIN
+              || $! == EWOULDBLOCK
+              || $self->with_ssl && _ssl_wants_read();
+            $err = "Could not read from socket: '" . ( $fh->can('errstr') ? $fh->errstr : $! ) . "'";
+            last;
+        }
+        if ( !$r ) {
+            $err = "Unexpected end of stream";
+            last;
         }
-        last unless length($msg) < $len;
+        # drain any bytes already decrypted by an SSL socket as well
+        last unless $self->with_ssl && $fh->pending;
     }
 
+    $fh->blocking($blocking) if defined $blocking;
+    if ( defined $err ) {
+        $self->_close;
+        MongoDB::NetworkError->throw("$err\n");
+    }
+
+    my $buf = \$self->{_read_ahead};
+    return if length($$buf) < 4;
+    my $len = unpack( P_INT32, $$buf );
+    MongoDB::ProtocolError->throw(
+        qq/Server reply of size $len exceeds maximum of / . $self->{max_message_size_bytes} )
+      if $len > $self->max_message_size_bytes;
+    return if length($$buf) < $len;
+
     $self->_set_last_used(time);
 
-    return $msg;
+    return substr( $$buf, 0, $len, '' );
+}
+
+# true if the last SSL read stopped partway through a TLS record
+sub _ssl_wants_read {
+    no warnings 'once';
+    return ( $IO::Socket::SSL::SSL_ERROR || 0 ) == IO::Socket::SSL::SSL_WANT_READ();
+}
+
+# Reads one reply for each of the given request IDs, in whatever order they
+# arrive, and returns them in a hash keyed on request ID.
+sub read_replies {
+    my ( $self, $request_ids ) = @_;
+    my %waiting = map { $_ => 1 } @$request_ids;
+    my %replies;
+
+    while (%waiting) {
+        my $msg = $self->read;
+        my $response_to = MongoDB::_Protocol::get_response_to($msg);
+        unless ( delete $waiting{$response_to} ) {
+            $self->_close;
+            MongoDB::ProtocolError->throw(
+                "response ID ($response_to) did not match any pipelined request ID");
+        }
+        $replies{$response_to} = $msg;
+    }
+
+    return \%replies;
 }
 
 sub _assert_ssl {
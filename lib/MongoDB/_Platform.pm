@@ -21,6 +21,8 @@ use version;
 our $VERSION = 'v2.2.3';
 
 use Config;
+use IO::Handle;
+use POSIX ();
 
 sub os_type {
     return ($^O eq "MSWin32") ? "Windows" : $^O;
@@ -31,4 +33,21 @@ sub platform_details {
     return "Perl $perl_version $Config{archname}";
 }
 
+# Called before forking workers: output still buffered would otherwise be
+# written once by the parent and again by each child.
+sub flush_std_handles {
+    $_->flush for \*STDOUT, \*STDERR;
+    return;
+}
+
+# Ends a forked worker with $status, without running destructors or END
+# blocks.  Whatever the worker inherited belongs to the parent, so
+# destroying it here would end the parent's sessions or kill its cursors.
+# _exit skips flushing too, so the worker's own output is flushed first.
+sub exit_forked_worker {
+    my ($status) = @_;
+    flush_std_handles();
+    POSIX::_exit($status);
+}
+
 1;
@@ -0,0 +1,205 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+package MongoDB::_Pool;
+
+# Tracks the MongoDB::_Link objects connected to a single server address.
+# Links are checked out for the duration of an operation and checked back
+# in afterwards.  Every link is tagged with the pool generation it was
+# created in; clearing the pool bumps the generation, so links that were
+# checked out at the time are discarded instead of reused on check in.
+
+use version;
+our $VERSION = 'v2.2.3';
+
+use Moo;
+use Scalar::Util qw/refaddr/;
+use Time::HiRes qw/time/;
+use MongoDB::_Types qw(
+    HostAddress
+    NonNegNum
+);
+use Types::Standard qw(
+    ArrayRef
+    HashRef
+    InstanceOf
+);
+use namespace::clean;
+
+has address => (
+    is       => 'ro',
+    required => 1,
+    isa      => HostAddress,
+);
+
+# zero means no limit
+has max_pool_size => (
+    is      => 'ro',
+    default => 100,
+    isa     => NonNegNum,
+);
+
+has min_pool_size => (
+    is      => 'ro',
+    default => 0,
+    isa     => NonNegNum,
+);
+
+# zero means idle links never expire
+has max_idle_time_sec => (
+    is      => 'ro',
+    default => 0,
+    isa     => NonNegNum,
+);
+
+has generation => (
+    is       => 'rwp',
+    init_arg => undef,
+    default  => 0,
+    isa      => NonNegNum,
+);
+
+# idle links, ordered from least to most recently checked in
+has _idle => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { [] },
+    isa      => ArrayRef [ InstanceOf ['MongoDB::_Link'] ],
+);
+
+# checked out links, keyed on refaddr
+has _in_use => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { {} },
+    isa      => HashRef [ InstanceOf ['MongoDB::_Link'] ],
+);
+
+sub idle_count { scalar @{ $_[0]{_idle} } }
+
+sub in_use_count { scalar keys %{ $_[0]{_in_use} } }
+
+sub size { $_[0]->idle_count + $_[0]->in_use_count }
+
+sub is_full {
+    my ($self) = @_;
+    return $self->{max_pool_size} && $self->size >= $self->{max_pool_size};
+}
+
+sub is_checked_out {
+    my ( $self, $link ) = @_;
+    return exists $self->{_in_use}{ refaddr $link };
+}
+
+sub all_links {
+    my ($self) = @_;
+    return ( @{ $self->{_idle} }, values %{ $self->{_in_use} } );
+}
+
+# Returns the most recently used idle link that is still valid, or nothing
+# if the caller needs to establish a new link.
+sub check_out {
+    my ($self) = @_;
+    my $now = time;
+
+    $self->_prune($now);
+
+    while ( my $link = pop @{ $self->{_idle} } ) {
+        if ( $self->_is_perished( $link, $now ) ) {
+            $link->_close;
+            next;
+        }
+        $self->{_in_use}{ refaddr $link } = $link;
+        return $link;
+    }
+
+    return;
+}
+
+# Checks out the idle links last used before $cutoff, for validation,
+# oldest first and no more than $max of them if given.
+sub check_out_idle_before {
+    my ( $self, $cutoff, $max ) = @_;
+    my $idle = $self->{_idle};
+    my @links;
+    while ( @$idle && $idle->[0]->last_used < $cutoff && !( $max && @links >= $max ) ) {
+        my $link = shift @$idle;
+        $self->{_in_use}{ refaddr $link } = $link;
+        push @links, $link;
+    }
+    return @links;
+}
+
+# Registers a newly connected link with the pool as checked out.
+sub add_link {
+    my ( $self, $link ) = @_;
+    $link->_set_generation( $self->{generation} );
+    $self->{_in_use}{ refaddr $link } = $link;
+    return $link;
+}
+
+# Returns true if the link was returned to the idle list; links that are
+# disconnected or from an earlier generation are closed instead.
+sub check_in {
+    my ( $self, $link ) = @_;
+
+    return unless delete $self->{_in_use}{ refaddr $link };
+
+    if ( $self->_is_perished( $link, time ) ) {
+        $link->_close;
+        return;
+    }
+
+    $link->_release_large_reply_buffer;
+    push @{ $self->{_idle} }, $link;
+    return 1;
+}
+
+# Invalidates all links: idle ones are closed now and checked out ones will
+# be closed when they are checked in.
+sub clear {
+    my ($self) = @_;
+    $self->_set_generation( $self->{generation} + 1 );
+    $_->_close for splice @{ $self->{_idle} };
+    return;
+}
+
+sub _is_perished {
+    my ( $self, $link, $now ) = @_;
+    return 1 unless $link->is_connected;
+    return 1 if $link->generation != $self->{generation};
+    my $max_idle = $self->{max_idle_time_sec};
+    return 1 if $max_idle && $now - $link->last_used > $max_idle;
+    return 0;
+}
+
+# close links that have been idle too long, oldest first, while keeping at
+# least min_pool_size links around
+sub _prune {
+    my ( $self, $now ) = @_;
+    my $idle = $self->{_idle};
+    while ( @$idle
+        && $self->size > $self->{min_pool_size}
+        && $self->_is_perished( $idle->[0], $now ) )
+    {
+        ( shift @$idle )->_close;
+    }
+    return;
+}
+
+1;
+
+# vim: ts=4 sts=4 sw=4 et:
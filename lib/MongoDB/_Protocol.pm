@@ -123,17 +123,25 @@ use constant {
     P_SECTION_SEQUENCE_SIZE_LENGTH => length( pack P_SECTION_SEQUENCE_SIZE, 0 ),
 };
 
+# Commands whose documents are sent as a type 1 document sequence, mapped
+# to the sequence identifier
+
+my %split_commands = (
+  insert => 'documents',
+  update => 'updates',
+  delete => 'deletes',
+);
+
+sub has_document_sequence {
+  my ( $command ) = @_;
+  return exists $split_commands{ $command };
+}
+
 # Takes a command, returns sections ready for joining
 
 sub prepare_sections {
   my ( $codec, $cmd ) = @_;
 
-  my %split_commands = (
-    insert => 'documents',
-    update => 'updates',
-    delete => 'deletes',
-  );
-
   $cmd = to_IxHash( $cmd );
 
   # Command is always first key in cmd
@@ -185,69 +193,91 @@ sub prepare_sections {
 # Takes a section hashref and encodes it for joining
 
 sub encode_section {
+    return join( '', _encode_section_parts(@_) );
+}
+
+# Encodes a section as a list of strings (section header, then documents)
+# that concatenate to the encoded section, so the caller can join all the
+# parts of a message exactly once.
+
+sub _encode_section_parts {
     my ( $codec, $section ) = @_;
 
     my $type = $section->{type};
-    my $ident = $section->{identifier};
     my @docs = map { $codec->encode_one( $_ ) } @{ $section->{documents} };
 
-    my $pl;
     if ( $type == 0 ) {
         # Assume a single doc if payload type is 0
-        $pl = $docs[0];
+        return ( pack( P_SECTION_PAYLOAD_TYPE, $type ), $docs[0] );
     } elsif ( $type == 1 ) {
-        $pl = pack( P_MSG_PL_1, 0, $ident )
-          . join( '', @docs );
-        # calculate size
-        substr( $pl, 0, 4, pack( P_SECTION_SEQUENCE_SIZE, length( $pl ) ) );
+        # size covers the sequence header and documents but not the type
+        my $header = pack( P_MSG_PL_1, 0, $section->{identifier} );
+        my $size = length $header;
+        $size += length for @docs;
+        substr( $header, 0, 4, pack( P_SECTION_SEQUENCE_SIZE, $size ) );
+        return ( pack( P_SECTION_PAYLOAD_TYPE, $type ) . $header, @docs );
     } else {
       MongoDB::ProtocolError->throw("Encode: Unsupported section payload type");
     }
-
-    # Prepend the section type
-    $pl = pack( P_SECTION_PAYLOAD_TYPE, $type ) . $pl;
-
-    return $pl;
 }
 
 # decode_section
 #
 #     MongoDB::_Protocol::decode_section( $section )
+#     MongoDB::_Protocol::decode_section( $buf, $offset, $length )
 #
 # Takes an encoded section and decodes it, exactly the opposite of encode_section.
+# The section may also be given as a region of a larger buffer; the buffer is
+# walked by offset, so only the documents themselves get copied out.
 
 sub decode_section {
-    my ( $doc ) = @_;
+    my ( undef, $offset, $length ) = @_;
+    my $buf = \$_[0];
+    $offset ||= 0;
+    $length = length($$buf) - $offset unless defined $length;
+    my $end = $offset + $length;
     my ( $type, $ident, @enc_docs );
     my $section = {};
 
-    ( $type ) = unpack( 'C', $doc );
-    my $payload = substr( $doc, P_SECTION_PAYLOAD_TYPE_LENGTH );
+    if ( $end > length($$buf)
+        || $length < P_SECTION_PAYLOAD_TYPE_LENGTH + P_SECTION_SEQUENCE_SIZE_LENGTH )
+    {
+      MongoDB::ProtocolError->throw("Decode: Section size incorrect");
+    }
+
+    ( $type ) = unpack( 'C', substr( $$buf, $offset, P_SECTION_PAYLOAD_TYPE_LENGTH ) );
+    my $pos = $offset + P_SECTION_PAYLOAD_TYPE_LENGTH;
 
     $section->{ type } = $type;
 
     # Pull size off and double check. Size is in the same place regardless of
     # payload type, as its a similar struct to a raw document
-    my ( $pl_size ) = unpack( P_SECTION_SEQUENCE_SIZE, $payload );
-    unless ( $pl_size == length( $payload ) ) {
+    my ( $pl_size ) = unpack( P_SECTION_SEQUENCE_SIZE, substr( $$buf, $pos, P_SECTION_SEQUENCE_SIZE_LENGTH ) );
+    unless ( $pl_size == $end - $pos ) {
       MongoDB::ProtocolError->throw("Decode: Section size incorrect");
     }
 
     if ( $type == 0 ) {
         # payload is a raw document
-        push @enc_docs, $payload;
+        push @enc_docs, substr( $$buf, $pos, $pl_size );
     } elsif ( $type == 1 ) {
-        $payload = substr( $payload, P_SECTION_SEQUENCE_SIZE_LENGTH );
-        # Pull out then remove
-        ( $ident ) = unpack( 'Z*', $payload );
+        $pos += P_SECTION_SEQUENCE_SIZE_LENGTH;
+        # identifier is a null terminated string
+        my $nul = index( $$buf, "\0", $pos );
+        if ( $nul < 0 || $nul >= $end ) {
+          MongoDB::ProtocolError->throw("Decode: Section identifier not terminated");
+        }
+        $ident = substr( $$buf, $pos, $nul - $pos );
         $section->{ identifier } = $ident;
-        $payload = substr( $payload, length ( $ident ) + 1 ); # add one for null termination
-
-        while ( length $payload ) {
-          my $doc_size = unpack( P_SECTION_SEQUENCE_SIZE, $payload );
-          my $doc = substr( $payload, 0, $doc_size );
-          $payload = substr( $payload, $doc_size );
-          push @enc_docs, $doc;
+        $pos = $nul + 1;
+
+        while ( $pos < $end ) {
+          my ( $doc_size ) = unpack( P_SECTION_SEQUENCE_SIZE, substr( $$buf, $pos, P_SECTION_SEQUENCE_SIZE_LENGTH ) );
+          if ( !$doc_size || $doc_size < 5 || $pos + $doc_size > $end ) {
+            MongoDB::ProtocolError->throw("Decode: Document size incorrect");
+          }
+          push @enc_docs, substr( $$buf, $pos, $doc_size );
+          $pos += $doc_size;
         }
     } else {
         MongoDB::ProtocolError->throw("Decode: Unsupported section payload type");
@@ -257,24 +287,31 @@ sub decode_section {
     return $section;
 }
 
-# method split_sections( $msg )
+# method split_sections( $msg, $offset )
 #
-# Splits sections based on their payload length header. Returns an array of
-# sections in packed form
+# Splits sections based on their payload length header, starting at $offset
+# (default 0). Returns an array of decoded sections; the message is walked in
+# place rather than copying the remainder after each section.
 
 sub split_sections {
-  my $msg = shift;
+  my ( undef, $offset ) = @_;
+  my $msg = \$_[0];
+  my $pos = $offset || 0;
+  my $end = length $$msg;
   my @sections;
-  while ( length $msg ) {
+  while ( $pos < $end ) {
     # get first section length
-    my ( undef, $section_length ) = unpack( P_SECTION_HEADER, $msg );
+    my ( undef, $section_length ) = unpack( P_SECTION_HEADER,
+      substr( $$msg, $pos, P_SECTION_PAYLOAD_TYPE_LENGTH + P_SECTION_SEQUENCE_SIZE_LENGTH ) );
+    MongoDB::ProtocolError->throw("Decode: Section size incorrect")
+      unless defined $section_length;
 
     # Add the payload type length as we reached over it for the length
-    my $section = substr( $msg, 0, $section_length + P_SECTION_PAYLOAD_TYPE_LENGTH );
+    my $length = $section_length + P_SECTION_PAYLOAD_TYPE_LENGTH;
 
-    push @sections, decode_section( $section );
+    push @sections, decode_section( $$msg, $pos, $length );
 
-    $msg = substr( $msg, $section_length + P_SECTION_PAYLOAD_TYPE_LENGTH );
+    $pos += $length;
   }
 
   return @sections;
@@ -283,6 +320,7 @@ sub split_sections {
 use constant {
   MSG_FB_CHECKSUM => 0,
   MSG_FB_MORE_TO_COME => 1,
+  MSG_FB_EXHAUST_ALLOWED => 16,
 };
 
 sub write_msg {
@@ -291,19 +329,22 @@ sub write_msg {
   # checksum is reserved for future use
   if ( $flags ) {
     $flagbits =
-        ( $flags->{checksum_present} ? 1 << MSG_FB_CHECKSUM     : 0 )
-      | ( $flags->{more_to_come}     ? 1 << MSG_FB_MORE_TO_COME : 0 );
+        ( $flags->{checksum_present} ? 1 << MSG_FB_CHECKSUM        : 0 )
+      | ( $flags->{more_to_come}     ? 1 << MSG_FB_MORE_TO_COME    : 0 )
+      | ( $flags->{exhaust_allowed}  ? 1 << MSG_FB_EXHAUST_ALLOWED : 0 );
   }
 
   my $request_id = int( rand( MAX_REQUEST_ID ) );
 
-  my @sections = prepare_sections( $codec, $cmd );
-
-  my $encoded_sections = join ('', ( map { encode_section( $codec, $_ ) } @sections ) );
+  # the sections are kept as separate strings until the total size is
+  # known, then joined into one buffer allocated at its final size, so a
+  # large document sequence is copied once rather than at every level
+  my @parts = map { _encode_section_parts( $codec, $_ ) }
+    prepare_sections( $codec, $cmd );
+  my $len = P_MSG_PREFIX_LENGTH;
+  $len += length for @parts;
 
-  my $msg = pack( P_MSG, 0, $request_id, 0, OP_MSG, 0 )
-    . $encoded_sections;
-  substr( $msg, 0, 4, pack( P_INT32, length($msg) ) );
+  my $msg = join( '', pack( P_MSG, $len, $request_id, 0, OP_MSG, $flagbits ), @parts );
   return ( $msg, $request_id );
 }
 
@@ -388,18 +429,21 @@ sub compress {
     my ($len, $request_id, $response_to, $op_code)
         = unpack(P_HEADER, $msg);
 
-    $msg = substr $msg, P_HEADER_LENGTH;
-
-    my $msg_comp = pack(
-        P_COMPRESSED,
-        0, $request_id, $response_to, OP_COMPRESSED,
-        $op_code,
-        length($msg),
-        $compressor->{id},
-    ).$compressor->{callback}->($msg);
-
-    substr($msg_comp, 0, 4, pack(P_INT32, length($msg_comp)));
-    return $msg_comp;
+    my $body = substr $msg, P_HEADER_LENGTH;
+    my $compressed = $compressor->{callback}->($body);
+    undef $body;
+
+    return join('',
+        pack(
+            P_COMPRESSED,
+            P_COMPRESSED_PREFIX_LENGTH + length($compressed),
+            $request_id, $response_to, OP_COMPRESSED,
+            $op_code,
+            length($msg) - P_HEADER_LENGTH,
+            $compressor->{id},
+        ),
+        $compressed,
+    );
 }
 
 # attempt to uncompress message
@@ -634,24 +678,38 @@ use constant {
     R_AWAIT_CAPABLE    => 3,
 };
 
+# Returns the responseTo field from a reply header.  OP_COMPRESSED keeps the
+# header of the message it wraps, so replies need not be uncompressed first.
+sub get_response_to {
+    my ($msg) = @_;
+    MongoDB::ProtocolError->throw("response was truncated")
+        if length($msg) < P_HEADER_LENGTH;
+    return ( unpack( P_HEADER, $msg ) )[2];
+}
+
 sub parse_reply {
-    my ( $msg, $request_id ) = @_;
+    my ( undef, $request_id ) = @_;
+
+    # work through a reference to the caller's buffer so that an
+    # uncompressed reply is parsed where it was read, without a copy
+    my $msg = \$_[0];
     MongoDB::ProtocolError->throw("response was truncated")
-        if length($msg) < MIN_REPLY_LENGTH;
+        if length($$msg) < MIN_REPLY_LENGTH;
 
-    $msg = try_uncompress($msg);
+    $msg = \try_uncompress($$msg)
+        if ( unpack( P_HEADER, $$msg ) )[3] == OP_COMPRESSED;
 
     my (
         $len, $msg_id, $response_to, $opcode, $bitflags, $cursor_id, $starting_from,
         $number_returned
-    ) = unpack( P_MSG, $msg );
+    ) = unpack( P_MSG, $$msg );
 
     # pre-check all conditions using a modifier in one statement for speed;
     # disambiguate afterwards only if an error exists
 
     do {
 
-        if ( length($msg) < $len ) {
+        if ( length($$msg) < $len ) {
             MongoDB::ProtocolError->throw("response was truncated");
         }
 
@@ -664,20 +722,22 @@ sub parse_reply {
                 "response ID ($response_to) did not match request ID ($request_id)");
         }
         }
-        if ( length($msg) < $len )
+        if ( length($$msg) < $len )
         || ( ( $opcode != OP_REPLY ) && ( $opcode != OP_MSG ) )
         || ( $response_to != $request_id );
 
 
     if ( $opcode == OP_MSG ) {
         # XXX Extract and check checksum - future support of crc32c
-        my @sections = split_sections( substr( $msg, P_MSG_PREFIX_LENGTH ) );
+        my @sections = split_sections( $$msg, P_MSG_PREFIX_LENGTH );
         # We have none of the other stuff? maybe flags... and an array of docs? erm
         return {
           flags => {
-            checksum_present => vec( $bitflags, MSG_FB_CHECKSUM, 1 ),
-            more_to_come    => vec( $bitflags, MSG_FB_MORE_TO_COME, 1 ),
+            checksum_present => ( $bitflags >> MSG_FB_CHECKSUM ) & 1,
+            more_to_come    => ( $bitflags >> MSG_FB_MORE_TO_COME ) & 1,
           },
+          # with more_to_come, the next reply will be in response to this one
+          request_id => $msg_id,
           # XXX Assumes the server never sends a type 1 payload. May change in future
           docs => $sections[0]->{documents}->[0]
         };
@@ -686,7 +746,7 @@ sub parse_reply {
         (
             $len, $msg_id, $response_to, $opcode, $bitflags, $cursor_id, $starting_from,
             $number_returned
-        ) = unpack( P_REPLY_HEADER, $msg );
+        ) = unpack( P_REPLY_HEADER, $$msg );
     }
 
     # returns non-zero cursor_id as blessed object to identify it as an
@@ -694,11 +754,10 @@ sub parse_reply {
     # from commands are handled differently: they are perl integers or
     # else Math::BigInt objects
 
-    substr( $msg, 0, MIN_REPLY_LENGTH, '' ),
         return {
         flags => {
-            cursor_not_found => vec( $bitflags, R_CURSOR_NOT_FOUND, 1 ),
-            query_failure    => vec( $bitflags, R_QUERY_FAILURE,    1 ),
+            cursor_not_found => ( $bitflags >> R_CURSOR_NOT_FOUND ) & 1,
+            query_failure    => ( $bitflags >> R_QUERY_FAILURE )    & 1,
         },
         cursor_id => (
             ( $cursor_id eq CURSOR_ZERO )
@@ -707,10 +766,134 @@ sub parse_reply {
           ),
         starting_from   => $starting_from,
         number_returned => $number_returned,
-        docs            => $msg,
+        docs            => substr( $$msg, MIN_REPLY_LENGTH ),
         };
 }
 
+#--------------------------------------------------------------------------#
+# BSON element walking
+#--------------------------------------------------------------------------#
+
+# Value sizes of BSON element types, by type byte.  Fixed sizes are given
+# directly; types whose value starts with an int32 length are listed in
+# %BSON_LENGTH_PREFIXED with the bytes the value has beyond that length.
+
+my %BSON_FIXED_SIZE = (
+    0x01 => 8,  # double
+    0x06 => 0,  # undefined
+    0x07 => 12, # ObjectId
+    0x08 => 1,  # boolean
+    0x09 => 8,  # datetime
+    0x0A => 0,  # null
+    0x10 => 4,  # int32
+    0x11 => 8,  # timestamp
+    0x12 => 8,  # int64
+    0x13 => 16, # decimal128
+    0x7F => 0,  # max key
+    0xFF => 0,  # min key
+);
+
+my %BSON_LENGTH_PREFIXED = (
+    0x02 => 4,  # string
+    0x03 => 0,  # document
+    0x04 => 0,  # array
+    0x05 => 5,  # binary: length excludes itself and the subtype
+    0x0C => 16, # DBPointer: string then ObjectId
+    0x0D => 4,  # code
+    0x0E => 4,  # symbol
+    0x0F => 0,  # code with scope
+);
+
+# index_document( $bson, $offset )
+#
+# Walks the top-level elements of the document at $offset (default 0)
+# without decoding them.  Returns a list of [ key, type, start, value,
+# end ] with the offsets of the element's type byte, its value and the
+# byte following it.  Keys are returned as encoded, in UTF-8 bytes.
+
+sub index_document {
+    my ( undef, $offset ) = @_;
+    my $bson = \$_[0];
+    $offset ||= 0;
+
+    my $doc_len = length($$bson) - $offset >= 5 ? unpack( P_INT32, substr( $$bson, $offset, 4 ) ) : 0;
+    MongoDB::ProtocolError->throw("Decode: Document size incorrect")
+      if $doc_len < 5 || $offset + $doc_len > length $$bson;
+
+    # position of the document's trailing null
+    my $end = $offset + $doc_len - 1;
+    my $pos = $offset + 4;
+    my ( @elements, $type, $nul, $value, $size );
+
+    while ( $pos < $end ) {
+        $type = ord substr( $$bson, $pos, 1 );
+        $nul = index( $$bson, "\0", $pos + 1 );
+        MongoDB::ProtocolError->throw("Decode: Element name not terminated")
+          if $nul < 0 || $nul >= $end;
+        $value = $nul + 1;
+
+        if ( exists $BSON_FIXED_SIZE{$type} ) {
+            $size = $BSON_FIXED_SIZE{$type};
+        }
+        elsif ( exists $BSON_LENGTH_PREFIXED{$type} ) {
+            $size = $value + 4 <= $end
+              ? unpack( P_INT32, substr( $$bson, $value, 4 ) ) + $BSON_LENGTH_PREFIXED{$type}
+              : -1;
+        }
+        elsif ( $type == 0x0B ) {
+            # regex: pattern and options cstrings
+            $size = index( $$bson, "\0", index( $$bson, "\0", $value ) + 1 ) + 1 - $value;
+        }
+        else {
+            MongoDB::ProtocolError->throw( sprintf( "Decode: Unsupported element type 0x%02X", $type ) );
+        }
+
+        MongoDB::ProtocolError->throw("Decode: Element size incorrect")
+          if $size < 0 || $value + $size > $end;
+
+        push @elements, [ substr( $$bson, $pos + 1, $nul - $pos - 1 ), $type, $pos, $value, $value + $size ];
+        $pos = $value + $size;
+    }
+
+    return @elements;
+}
+
+# split_cursor_batch( $reply )
+#
+# For a cursor command reply, returns the reply with its firstBatch or
+# nextBatch array removed, an array reference of the encoded documents of
+# that batch and the name of the batch field.  Returns nothing if the
+# reply has no cursor batch.  The documents can then be decoded lazily
+# while the rest of the reply is decoded as usual.
+
+sub split_cursor_batch {
+    my $reply = \$_[0];
+
+    my ($cursor) = grep { $_->[0] eq 'cursor' && $_->[1] == 0x03 } index_document($$reply);
+    return unless $cursor;
+
+    my ($batch) =
+      grep { $_->[1] == 0x04 && ( $_->[0] eq 'firstBatch' || $_->[0] eq 'nextBatch' ) }
+      index_document( $$reply, $cursor->[3] );
+    return unless $batch;
+
+    my @docs = map {
+        MongoDB::ProtocolError->throw("Decode: Cursor batch element is not a document")
+          unless $_->[1] == 0x03;
+        substr( $$reply, $_->[3], $_->[4] - $_->[3] )
+    } index_document( $$reply, $batch->[3] );
+
+    # cut out the batch element and shrink the reply and cursor documents
+    my $cut = $batch->[4] - $batch->[2];
+    my $rest = join( '', substr( $$reply, 0, $batch->[2] ), substr( $$reply, $batch->[4] ) );
+    for my $doc_offset ( 0, $cursor->[3] ) {
+        substr( $rest, $doc_offset, 4,
+            pack( P_INT32, unpack( P_INT32, substr( $rest, $doc_offset, 4 ) ) - $cut ) );
+    }
+
+    return ( $rest, \@docs, $batch->[0] );
+}
+
 #--------------------------------------------------------------------------#
 # utility functions
 #--------------------------------------------------------------------------#
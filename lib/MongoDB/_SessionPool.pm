@@ -52,6 +52,14 @@ has _pool_epoch => (
     default => 0,
 );
 
+# process the pooled sessions belong to; a forked child resets the pool
+# instead of sharing the parent's sessions
+has _pid => (
+    is => 'rwp',
+    init_arg => undef,
+    default => sub { $$ },
+);
+
 # Returns a L<MongoDB::ServerSession> that was at least one minute remaining
 # before session times out. Returns undef if no sessions available.
 #
@@ -59,6 +67,7 @@ has _pool_epoch => (
 
 sub get_server_session {
     my ( $self ) = @_;
+    $self->reset_pool if $self->{_pid} != $$;
 
     if ( scalar( @{ $self->_server_session_pool } ) > 0 ) {
         my $session_timeout = $self->topology->logical_session_timeout_minutes;
@@ -80,6 +89,7 @@ sub get_server_session {
 
 sub retire_server_session {
     my ( $self, $server_session ) = @_;
+    $self->reset_pool if $self->{_pid} != $$;
 
     return if $server_session->pool_epoch != $self->_pool_epoch;
 
@@ -121,18 +131,22 @@ sub end_all_sessions {
     }
 }
 
-# When reconnecting a client after a fork, we need to clear the pool
-# without ending sessions with the server and increment the pool epoch
-# so existing sessions aren't checked back in.
+# After a fork, we need to clear the pool without ending sessions with the
+# server and increment the pool epoch so existing sessions aren't checked
+# back in.
 sub reset_pool {
     my ( $self ) = @_;
     $self->_clear_server_session_pool;
     $self->_set__pool_epoch( $self->_pool_epoch + 1 );
+    $self->_set__pid($$);
 }
 
 sub DEMOLISH {
     my ( $self, $in_global_destruction ) = @_;
 
+    # sessions inherited across a fork are the parent's to end
+    return if $self->{_pid} != $$;
+
     $self->end_all_sessions;
 }
 
@@ -23,16 +23,21 @@ use Moo;
 use BSON;
 use MongoDB::Error;
 use MongoDB::Op::_Command;
+use MongoDB::Op::_KillCursors;
 use MongoDB::_Platform;
 use MongoDB::ReadPreference;
 use MongoDB::_Constants;
+use MongoDB::_CompressionStats;
+use MongoDB::_KillCursorsQueue;
 use MongoDB::_Link;
+use MongoDB::_Pool;
 use MongoDB::_Types qw(
     Boolish
     BSONCodec
     CompressionType
     Document
     NonNegNum
+    ServerSelectionPolicy
     TopologyType
     ZlibCompressionLevel
     to_IxHash
@@ -51,7 +56,9 @@ use MongoDB::_Protocol;
 use Config;
 use List::Util qw/first max min/;
 use Safe::Isa;
+use Scalar::Util qw/weaken/;
 use Time::HiRes qw/time usleep/;
+use Errno qw/EINTR/;
 
 use namespace::clean;
 
@@ -113,6 +120,30 @@ has zlib_compression_level => (
     default => sub { -1 },
 );
 
+has compression_min_bytes => (
+    is => 'ro',
+    isa => NonNegNum,
+    default => 0,
+);
+
+has compression_adaptive => (
+    is => 'ro',
+    isa => Boolish,
+    default => 0,
+);
+
+# shared by the compressors of all servers, as it is kept per command name
+has _compression_stats => (
+    is => 'lazy',
+    init_arg => undef,
+    builder => '_build__compression_stats',
+);
+
+sub _build__compression_stats {
+    my ($self) = @_;
+    return $self->compression_adaptive ? MongoDB::_CompressionStats->new : undef;
+}
+
 has type => (
     is      => 'ro',
     writer  => '_set_type',
@@ -172,6 +203,52 @@ has socket_check_interval_sec => (
     isa => Num,
 );
 
+# cursors to kill on the next link checked in for their server
+has _kill_queue => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { MongoDB::_KillCursorsQueue->new },
+    isa      => InstanceOf ['MongoDB::_KillCursorsQueue'],
+);
+
+# absolute time by which the operation being dispatched must be done, if
+# the client has a timeout_ms; set with local by MongoDB::_Dispatcher, so
+# that server selection and the links it hands out draw from it
+has _deadline => (
+    is       => 'ro',
+    init_arg => undef,
+);
+
+# [ link, request ID, deadline, session ] for requests whose replies nobody
+# waits for, such as the losing half of a hedged read; see drain_link
+has _draining => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { [] },
+    isa      => ArrayRef,
+);
+
+# process the links and pools were made in; a forked child drops them on
+# first use, see _check_for_fork
+has _pid => (
+    is       => 'rwp',
+    init_arg => undef,
+    default  => sub { $$ },
+);
+
+# guard for the event loop timer that drives background scans, if any
+has _monitor_timer => (
+    is       => 'rw',
+    init_arg => undef,
+);
+
+# guard for the timer of the next step of pool upkeep after a background
+# scan; see _background_scan
+has _upkeep_timer => (
+    is       => 'rw',
+    init_arg => undef,
+);
+
 has server_selection_timeout_sec => (
     is      => 'ro',
     default => 60,
@@ -189,6 +266,14 @@ has server_selector => (
     isa => Maybe[CodeRef],
 );
 
+# how to choose among servers in the latency window: 'random', or
+# 'least_loaded' to take the less busy of two random ones
+has server_selection_policy => (
+    is      => 'ro',
+    default => 'random',
+    isa => ServerSelectionPolicy,
+);
+
 has ewma_alpha => (
     is      => 'ro',
     default => 0.2,
@@ -201,6 +286,24 @@ has link_options => (
     isa => HashRef,
 );
 
+has max_pool_size => (
+    is      => 'ro',
+    default => 100,
+    isa => NonNegNum,
+);
+
+has min_pool_size => (
+    is      => 'ro',
+    default => 0,
+    isa => NonNegNum,
+);
+
+has max_idle_time_sec => (
+    is      => 'ro',
+    default => 0,
+    isa => NonNegNum,
+);
+
 has bson_codec => (
     is       => 'ro',
     default  => sub { BSON->new },
@@ -270,7 +373,8 @@ has stale => (
     default => 1,
 );
 
-# servers, links and rtt_ewma_sec are all hashes on server address
+# servers, links, pools, rtt_ewma_sec and op_latency_ewma are all hashes on
+# server address
 
 has servers => (
     is      => 'ro',
@@ -284,18 +388,42 @@ has _incompatible_servers => (
     isa => ArrayRef[InstanceOf['MongoDB::_Server']],
 );
 
+# links used for monitoring; each is also registered with its pool
 has links => (
     is      => 'ro',
     default => sub { {} },
     isa => HashRef[InstanceOf['MongoDB::_Link']],
 );
 
+has pools => (
+    is      => 'ro',
+    default => sub { {} },
+    isa => HashRef[InstanceOf['MongoDB::_Pool']],
+);
+
 has rtt_ewma_sec => (
     is      => 'ro',
     default => sub { {} },
     isa => HashRef[Num],
 );
 
+# [ moving average of operation times, time of the last one ], as seen by
+# this process; only kept for the least_loaded selection policy
+has op_latency_ewma => (
+    is      => 'ro',
+    default => sub { {} },
+    isa => HashRef[ArrayRef],
+);
+
+# selection method and read preference => servers in the latency window;
+# cleared whenever a server description is added, replaced or removed
+has _selection_cache => (
+    is       => 'ro',
+    init_arg => undef,
+    default  => sub { {} },
+    isa      => HashRef[ArrayRef],
+);
+
 has cluster_time => (
     is => 'rwp',
     isa => Maybe[Document],
@@ -441,9 +569,13 @@ sub all_data_bearing_servers { return grep { $_->is_data_bearing } $_[0]->all_se
 
 sub check_address {
     my ( $self, $address ) = @_;
+    $self->_check_for_fork if $self->{_pid} != $$;
 
+    # a link checked out from the pool belongs to its caller, so it can't be
+    # used for monitoring
     my $link = $self->links->{$address};
-    if ( $link && $link->is_connected ) {
+    my $pool = $self->pools->{$address};
+    if ( $link && $link->is_connected && !( $pool && $pool->is_checked_out($link) ) ) {
         $self->_update_topology_from_link( $link, with_handshake => 0 );
     }
     else {
@@ -454,9 +586,333 @@ sub check_address {
     return;
 }
 
+sub check_in_link {
+    my ( $self, $link ) = @_;
+    $self->_poll_draining if @{ $self->{_draining} };
+    $link->_clear_deadline;
+    $self->_send_queued_kills($link)
+      if $self->{_kill_queue}->count( $link->address ) && $link->is_connected;
+    # if the pool was replaced, the link is simply dropped
+    my $pool = $self->pools->{ $link->address }
+      or return;
+    $self->_record_op_latency($link) if defined $link->op_started;
+    $pool->check_in($link);
+    return;
+}
+
+# Queues a MongoDB::Op::_KillCursors op instead of sending it.  The cursor
+# IDs go out with the next link for $address that is checked in, or sooner
+# on an idle pooled link once enough of them are queued or the oldest has
+# waited too long.  Meant for cursor destructors, so it never throws and
+# never connects.
+sub defer_kill_cursors {
+    my ( $self, $address, $op ) = @_;
+    $self->{_kill_queue}->add( $address, $op );
+    $self->_flush_due_kills;
+    return;
+}
+
+# Removes and returns [ address, op ] for each kill queued under $session,
+# for the caller to send before the session ends
+sub take_session_kills {
+    my ( $self, $session ) = @_;
+    return $self->{_kill_queue}->take_session($session);
+}
+
+# Takes a checked out link with a request in flight whose reply the caller
+# won't read.  The reply is read once it arrives, any cursor it opened is
+# queued to be killed under the request's session, and the link goes back
+# to its pool.  Links still waiting after the socket timeout are closed.
+sub drain_link {
+    my ( $self, $link, $request_id, $session ) = @_;
+    my $timeout = $link->socket_timeout;
+    push @{ $self->{_draining} },
+      [ $link, $request_id, defined $timeout && $timeout >= 0 ? time + $timeout : undef, $session ];
+    return;
+}
+
+sub _poll_draining {
+    my ($self) = @_;
+    my $draining = $self->{_draining};
+
+    my $fds = '';
+    $fds |= $_->[0]->fdset for grep { $_->[0]->is_connected } @$draining;
+    my $nfound = select( my $rout = $fds, undef, undef, 0 );
+    $rout = '' unless $nfound > 0;
+
+    my $now = time;
+    for my $entry ( splice @$draining ) {
+        my ( $link, $request_id, $deadline, $session ) = @$entry;
+        my $msg;
+        if ( $link->is_connected
+            && ( vec( $rout, fileno( $link->fh ), 1 ) || $link->with_ssl && $link->fh->pending ) )
+        {
+            # some errors, like an oversized reply, leave the link open
+            eval { $msg = $link->read_available; 1 }
+              or $link->_close;
+        }
+        elsif ( $link->is_connected && ( !defined $deadline || $now < $deadline ) ) {
+            push @$draining, $entry;
+            next;
+        }
+        else {
+            $link->_close;
+        }
+
+        # read errors close the link; a partial reply waits for more
+        if ( !defined $msg && $link->is_connected ) {
+            push @$draining, $entry;
+            next;
+        }
+
+        $self->_kill_drained_cursor( $link->address, $msg, $request_id, $session )
+          if defined $msg;
+        $link->_clear_op_started;
+        $link->_clear_deadline;
+        my $pool = $self->pools->{ $link->address };
+        $pool->check_in($link) if $pool;
+    }
+
+    return;
+}
+
+sub _kill_drained_cursor {
+    my ( $self, $address, $msg, $request_id, $session ) = @_;
+    my $cursor = eval {
+        my $reply = MongoDB::_Protocol::parse_reply( $msg, $request_id );
+        $self->bson_codec->decode_one( $reply->{docs} )->{cursor};
+    };
+    return unless $cursor && $cursor->{id};
+
+    my ( $db_name, $coll_name ) = split( /\./, $cursor->{ns}, 2 );
+    $self->defer_kill_cursors(
+        $address,
+        MongoDB::Op::_KillCursors->_new(
+            db_name             => $db_name,
+            coll_name           => $coll_name,
+            full_name           => $cursor->{ns},
+            bson_codec          => $self->bson_codec,
+            cursor_ids          => [ $cursor->{id} ],
+            monitoring_callback => $self->monitoring_callback,
+            session             => $session,
+        )
+    );
+    return;
+}
+
+sub _flush_due_kills {
+    my ($self) = @_;
+    for my $address ( $self->{_kill_queue}->due(time) ) {
+        my $server = $self->servers->{$address};
+        if ( !$server || !$server->is_available ) {
+            # the server is gone and its cursors with it
+            $self->{_kill_queue}->take($address);
+            next;
+        }
+        # otherwise the kills wait for a link to be checked in
+        my $pool = $self->pools->{$address};
+        my $link = $pool && $pool->check_out
+          or next;
+        $self->check_in_link($link);
+    }
+    return;
+}
+
+# The kills are sent with their cursors' sessions and acknowledged, so a
+# rejected kill shows up in command monitoring rather than being lost.
+# Failures are otherwise ignored, as with any kill.
+sub _send_queued_kills {
+    my ( $self, $link ) = @_;
+    for my $op ( $self->{_kill_queue}->take( $link->address ) ) {
+        eval { $op->execute($link); 1 } or do {
+            $link->_close;
+            last;
+        };
+    }
+    return;
+}
+
+# Checks several servers at once.  New connections are started without
+# blocking and ismaster is sent on every link before waiting on a single
+# select, so the check takes as long as the slowest server rather than the
+# sum of all of them.  Replies update the topology as they arrive.
+sub _check_addresses {
+    my ( $self, @addresses ) = @_;
+
+    # a single server gains nothing from multiplexing
+    return $self->check_address( $addresses[0] ) if @addresses == 1;
+
+    my ( %connecting, %checking, %is_new );
+
+    for my $address (@addresses) {
+        my $link = $self->links->{$address};
+        my $pool = $self->pools->{$address};
+        if ( $link && $link->is_connected && !( $pool && $pool->is_checked_out($link) ) ) {
+            $checking{$address} = $link;
+            next;
+        }
+        $link = MongoDB::_Link->new( %{$self->link_options}, address => $address );
+        eval { $link->start_connect; 1 } or do {
+            $self->_reset_address_to_unknown( $address, $@ || "Unknown error" );
+            next;
+        };
+        $connecting{$address} = $link;
+    }
+
+    my $timeout = $self->link_options->{connect_timeout};
+    my $deadline = defined $timeout && $timeout >= 0 ? time + $timeout : undef;
+
+    while (%connecting) {
+        my $fds = '';
+        $fds |= $_->fdset for values %connecting;
+        my ( $nfound, undef, $wout, $eout ) = $self->_select_until( $deadline, undef, $fds, $fds );
+        last unless $nfound;
+        for my $address ( keys %connecting ) {
+            my $link = $connecting{$address};
+            my $fd = fileno $link->fh;
+            next unless vec( $wout, $fd, 1 ) || vec( $eout, $fd, 1 );
+            my $done = eval { $link->finish_connect };
+            if ( !defined $done ) {
+                delete $connecting{$address};
+                $self->_reset_address_to_unknown( $address, $@ || "Unknown error" );
+            }
+            elsif ($done) {
+                delete $connecting{$address};
+                $self->links->{$address} = $checking{$address} = $link;
+                $is_new{$address} = 1;
+            }
+        }
+    }
+
+    for my $address ( keys %connecting ) {
+        $connecting{$address}->_close;
+        $self->_reset_address_to_unknown( $address,
+            MongoDB::NetworkError->new( message => qq/Could not connect to '$address': timeout\n/ ) );
+    }
+
+    # as in _run_ismaster, the connect timeout bounds the wait for replies
+    $deadline = defined $timeout && $timeout >= 0 ? time + $timeout : undef;
+
+    my %pending;
+    for my $address ( keys %checking ) {
+        my $link = $checking{$address};
+        $self->publish_server_heartbeat_started( $link )
+          if $self->monitoring_callback;
+        my $start_time = time;
+        my $op = $self->_ismaster_op( $link, $is_new{$address} );
+        my ( $op_bson, $request_id, $write_opt );
+        eval {
+            ( $op_bson, $request_id, $write_opt ) = $op->_prepare_message($link);
+            $link->write( $op_bson, $write_opt );
+            1;
+        } or do {
+            my $err = $@ || "Unknown error";
+            $op->publish_command_exception($err) if $op->monitoring_callback;
+            $self->_update_topology_from_ismaster( $link, $start_time, undef, $err );
+            next;
+        };
+        $pending{$address} = [ $link, $op, $request_id, $start_time ];
+    }
+
+    while (%pending) {
+        # links with decrypted SSL data are ready without a select
+        my @ready = grep { $_->[0]->with_ssl && $_->[0]->fh->pending } values %pending;
+        unless (@ready) {
+            my $fds = '';
+            $fds |= $_->[0]->fdset for values %pending;
+            my ( $nfound, $rout ) = $self->_select_until( $deadline, $fds );
+            last unless $nfound;
+            @ready = grep { vec( $rout, fileno( $_->[0]->fh ), 1 ) } values %pending;
+        }
+
+        for my $entry (@ready) {
+            my ( $link, $op, $request_id, $start_time ) = @$entry;
+            my $address = $link->address;
+            my ( $is_master, $err );
+            my $msg = eval { $link->read_available };
+            if ( $@ ) {
+                $err = $@;
+                $op->publish_command_exception($err) if $op->monitoring_callback;
+            }
+            elsif ( defined $msg ) {
+                $is_master = eval { $op->_handle_reply( $link, $msg, $request_id )->output }
+                  or $err = $@ || "Unknown error";
+            }
+            next unless $is_master || $err;
+
+            delete $pending{$address};
+            # an earlier reply may have removed this server
+            next unless $self->servers->{$address};
+            $self->_update_topology_from_ismaster( $link, $start_time, $is_master, $err );
+            $self->_finish_new_link( $address, $link ) if $is_new{$address};
+        }
+    }
+
+    for my $entry ( values %pending ) {
+        my ( $link, $op, undef, $start_time ) = @$entry;
+        $link->_close;
+        next unless $self->servers->{ $link->address };
+        my $err = MongoDB::NetworkTimeout->new(
+            message => "Timed out while waiting for socket to become ready for reading\n" );
+        $op->publish_command_exception($err) if $op->monitoring_callback;
+        $self->_update_topology_from_ismaster( $link, $start_time, undef, $err );
+    }
+
+    return;
+}
+
+# select on the given read, write and error fdsets until something is ready
+# or the deadline (if any) passes; returns the number of ready handles
+# followed by the resulting fdsets, or zero on timeout
+sub _select_until {
+    my ( $self, $deadline, @fdsets ) = @_;
+    while () {
+        my $remaining = defined $deadline ? $deadline - time : undef;
+        return 0 if defined $remaining && $remaining <= 0;
+        my ( $rout, $wout, $eout ) = @fdsets;
+        my $nfound = select( $rout, $wout, $eout, $remaining );
+        next if $nfound == -1 && $! == EINTR;
+        return $nfound > 0 ? ( $nfound, $rout, $wout, $eout ) : 0;
+    }
+}
+
+# Waits until at least one of @$links has something to read or $deadline
+# passes, and returns the links that are ready.
+sub _wait_readable {
+    my ( $self, $links, $deadline ) = @_;
+
+    # decrypted SSL data doesn't show up in select
+    my @ready = grep { $_->with_ssl && $_->fh->pending } @$links;
+    return @ready if @ready;
+
+    my $fds = '';
+    $fds |= $_->fdset for @$links;
+    my ( $nfound, $rout ) = $self->_select_until( $deadline, $fds );
+    return unless $nfound;
+    return grep { vec( $rout, fileno( $_->fh ), 1 ) } @$links;
+}
+
 sub close_all_links {
     my ($self) = @_;
     delete $self->links->{ $_->address } for $self->all_servers;
+    $_->clear for values %{ $self->pools };
+    return;
+}
+
+# A forked child shares the parent's sockets, so on its first operation it
+# drops every link it inherited and makes its own as they are needed.  The
+# links close only the child's descriptors (see MongoDB::_Link::_close), and
+# server descriptions are kept, so workers start without rescanning the
+# deployment.  Cursors queued to be killed are left for the parent.
+sub _check_for_fork {
+    my ($self) = @_;
+    $self->_set__pid($$);
+    my @links = map { $_->all_links } values %{ $self->pools };
+    push @links, map { $_->[0] } splice @{ $self->{_draining} };
+    $_->_close for @links;
+    %{ $self->links } = ();
+    %{ $self->pools } = ();
+    $self->{_kill_queue} = MongoDB::_KillCursorsQueue->new;
     return;
 }
 
@@ -475,6 +931,7 @@ sub _maybe_get_txn_error_labels_and_unpin_from {
 
 sub get_readable_link {
     my ( $self, $op ) = @_;
+    $self->_check_for_fork if $self->{_pid} != $$;
     $self->_check_for_uri_changes;
 
     my $read_pref = defined $op ? $op->read_preference : undef;
@@ -485,7 +942,7 @@ sub get_readable_link {
       : $self->type eq "Sharded" ? '_find_readable_mongos_server'
       :                            "_find_${mode}_server";
 
-    if ( $mode eq 'primary' && $self->current_primary && $self->next_scan_time > time() )
+    if ( $mode eq 'primary' && $self->current_primary && !$self->_scan_is_due( time() ) )
     {
         my $link = $self->_get_server_link( $self->current_primary, $method );
         return $link if $link;
@@ -513,6 +970,7 @@ sub get_readable_link {
 
 sub get_specific_link {
     my ( $self, $address, $op ) = @_;
+    $self->_check_for_fork if $self->{_pid} != $$;
     $self->_check_for_uri_changes;
 
     my $server = $self->servers->{$address};
@@ -527,8 +985,39 @@ sub get_specific_link {
     }
 }
 
+# Returns a link to a server other than $address that is suitable for $op's
+# read preference, for hedging a read; returns nothing if there is none.
+# Unlike the other get_*_link methods, this neither scans nor waits: only
+# servers with an idle pooled link are candidates, as connecting would hold
+# the hedge up past the delay that called for it.
+sub get_hedge_link {
+    my ( $self, $op, $address ) = @_;
+    my $read_pref = $op->read_preference
+      or return;
+
+    # selecting from given candidates doesn't filter on server type
+    my $mode  = lc $read_pref->mode;
+    my $pools = $self->pools;
+    my @others = grep {
+        $_->address ne $address
+          && ( $_->type eq 'RSSecondary' || $_->type eq 'RSPrimary' && $mode ne 'secondary' )
+          && $pools->{ $_->address }
+          && $pools->{ $_->address }->idle_count
+    } $self->all_servers;
+    return unless @others;
+
+    my $method = "_find_${mode}_server";
+    my $server = eval { $self->$method( $read_pref, @others ) };
+    return unless $server && $server->address ne $address;
+
+    my $link = $pools->{ $server->address }->check_out
+      or return;
+    return $self->_prepare_link($link);
+}
+
 sub get_writable_link {
     my ( $self, $op ) = @_;
+    $self->_check_for_fork if $self->{_pid} != $$;
     $self->_check_for_uri_changes;
 
     my $method =
@@ -537,7 +1026,7 @@ sub get_writable_link {
       : "_find_primary_server";
 
 
-    if ( $self->current_primary && $self->next_scan_time > time() ) {
+    if ( $self->current_primary && !$self->_scan_is_due( time() ) ) {
         my $link = $self->_get_server_link( $self->current_primary, $method );
         return $link if $link;
     }
@@ -573,17 +1062,125 @@ sub mark_stale {
     return;
 }
 
+# Runs scans from an event loop timer every heartbeat_frequency_sec, so
+# operations don't pay for them.  After each scan, the monitor also tops
+# pools up to min_pool_size and pings idle links that have passed
+# socket_check_interval, so operations can skip that check.
+sub start_background_monitor {
+    my ( $self, $backend ) = @_;
+    $self->_schedule_background_scan( $backend, 0 );
+    return;
+}
+
+sub stop_background_monitor {
+    my ($self) = @_;
+    $self->_monitor_timer(undef);
+    $self->_upkeep_timer(undef);
+    return;
+}
+
+sub _schedule_background_scan {
+    my ( $self, $backend, $delay ) = @_;
+    weaken( my $weak_self = $self );
+    $self->_monitor_timer(
+        $backend->timer(
+            $delay,
+            sub {
+                return unless $weak_self;
+                $weak_self->_background_scan($backend);
+                $weak_self->_schedule_background_scan( $backend, $weak_self->heartbeat_frequency_sec );
+            }
+        )
+    );
+    return;
+}
+
+# The monitor runs in the event loop, where blocking I/O holds up every
+# other event, so its work is cut into steps that each wait on the network
+# once: the scan, which checks all servers at once, and then, each from a
+# timer of its own, one ping of an idle link or one new pooled link at a
+# time.  A step may still hold the loop for up to the connect or socket
+# timeout if a server stops answering.
+sub _background_scan {
+    my ( $self, $backend ) = @_;
+
+    # errors here resurface in the next operation that needs the server
+    eval { $self->scan_all_servers(1) };
+
+    $self->_flush_due_kills;
+
+    my @addresses = grep { $self->pools->{$_} }
+      map { $_->address } grep { $_->is_available } $self->all_servers;
+    $self->_schedule_upkeep( $backend, \@addresses, time - $self->socket_check_interval_sec );
+
+    return;
+}
+
+sub _schedule_upkeep {
+    my ( $self, $backend, $addresses, $idle_cutoff ) = @_;
+    return $self->_upkeep_timer(undef) unless @$addresses;
+
+    weaken( my $weak_self = $self );
+    $self->_upkeep_timer(
+        $backend->timer(
+            0,
+            sub {
+                return unless $weak_self;
+                shift @$addresses
+                  unless $weak_self->_upkeep_step( $addresses->[0], $idle_cutoff );
+                $weak_self->_schedule_upkeep( $backend, $addresses, $idle_cutoff );
+            }
+        )
+    );
+    return;
+}
+
+# Pings one link of the pool for $address that has been idle since before
+# $idle_cutoff or, failing that, opens one toward min_pool_size.  Returns
+# true if there may be more to do.
+sub _upkeep_step {
+    my ( $self, $address, $idle_cutoff ) = @_;
+    my $server = $self->servers->{$address};
+    my $pool   = $self->pools->{$address};
+    return unless $server && $server->is_available && $pool;
+
+    if ( my ($link) = $pool->check_out_idle_before( $idle_cutoff, 1 ) ) {
+        # a failed ping closes the link, so check in discards it
+        $self->_ping_server($link);
+        $pool->check_in($link);
+        return 1;
+    }
+
+    return unless $pool->size < $pool->min_pool_size;
+    my $link = eval { $self->_add_pool_link( $server, $pool ) }
+      or return;
+    $pool->check_in($link);
+    return 1;
+}
+
+# With a background monitor, scans happen on its timer; only step in if it
+# has fallen a full heartbeat behind, e.g. because the event loop is blocked.
+sub _scan_is_due {
+    my ( $self, $now ) = @_;
+    my $due = $self->next_scan_time;
+    $due += $self->heartbeat_frequency_sec if $self->_monitor_timer;
+    return $due < $now;
+}
+
 sub scan_all_servers {
     my ($self, $force) = @_;
+    $self->_check_for_fork if $self->{_pid} != $$;
 
-    my ( $next, @ordinary, @to_check );
+    my @to_check;
     my $start_time = time;
     my $cooldown_time = $force ? $start_time : $start_time - COOLDOWN_SECS;
 
     # anything not updated since scan start is eligible for a check; when all servers
     # are updated, the loop terminates; Unknown servers aren't checked if
     # they are in the cooldown window since we don't want to wait the connect
-    # timeout each attempt when they are unlikely to have changed status
+    # timeout each attempt when they are unlikely to have changed status.
+    # Eligible servers are checked concurrently; servers discovered along the
+    # way are picked up by the next pass
     while (1) {
         @to_check =
           grep {
@@ -594,18 +1191,7 @@ sub scan_all_servers {
 
         last unless @to_check;
 
-        if ( $next = first { $_->type eq 'RSPrimary' } @to_check ) {
-            $self->check_address( $next->address );
-        }
-        elsif ( $next = first { $_->type eq 'PossiblePrimary' } @to_check ) {
-            $self->check_address( $next->address );
-        }
-        elsif ( @ordinary = grep { $_->type ne 'Unknown' && $_->type ne 'RSGhost' } @to_check ) {
-            $self->_check_oldest_server(@ordinary);
-        }
-        else {
-            $self->_check_oldest_server(@to_check);
-        }
+        $self->_check_addresses( map { $_->address } @to_check );
     }
 
     my $now = time();
@@ -649,6 +1235,8 @@ sub _add_address_as_unknown {
     $self->publish_server_opening($address)
       if $self->monitoring_callback;
 
+    $self->_clear_selection_cache;
+
     return $self->servers->{$address} = MongoDB::_Server->new(
         address          => $address,
         last_update_time => $last_update || EPOCH,
@@ -666,20 +1254,6 @@ sub _check_for_primary {
     return 1;
 }
 
-sub _check_oldest_server {
-    my ( $self, @to_check ) = @_;
-
-    my @ordered =
-      map { $_->[0] }
-      sort { $a->[1] <=> $b->[1] || rand() <=> rand() } # random if equal
-      map { [ $_, $_->last_update_time ] }         # ignore partial secs
-      @to_check;
-
-    $self->check_address( $ordered[0]->address );
-
-    return;
-}
-
 my $max_int32 = 2147483647;
 
 sub _check_wire_versions {
@@ -861,37 +1435,43 @@ sub _filter_fresh_servers {
 # This works for reads and writes; for writes, $read_pref will be undef
 sub _find_available_server {
     my ( $self, $read_pref, @candidates ) = @_;
-    $self->_check_staleness_compatibility($read_pref) if $read_pref;
-    push @candidates, $self->all_servers unless @candidates;
-    my $selector = $self->server_selector;
-    return $self->_get_server_in_latency_window(
-      [ grep { $_->is_available }
-          $selector ? $selector->(@candidates) : @candidates ]
-    );
+    return $self->_select_from_window( available => $read_pref, \@candidates, sub {
+        $self->_check_staleness_compatibility($read_pref) if $read_pref;
+        push @candidates, $self->all_servers unless @candidates;
+        my $selector = $self->server_selector;
+        return $self->_latency_window(
+          [ grep { $_->is_available }
+              $selector ? $selector->(@candidates) : @candidates ]
+        );
+    } );
 }
 
 # This uses read preference to check for max staleness compatibility in
 # mongos, but otherwise read preference is ignored (mongos will pass it on)
 sub _find_readable_mongos_server {
     my ( $self, $read_pref, @candidates ) = @_;
-    $self->_check_staleness_compatibility($read_pref);
-    push @candidates, $self->all_servers unless @candidates;
-    my $selector = $self->server_selector;
-    return $self->_get_server_in_latency_window(
-      [ grep { $_->is_available }
-          $selector ? $selector->(@candidates) : @candidates ]
-    );
+    return $self->_select_from_window( mongos => $read_pref, \@candidates, sub {
+        $self->_check_staleness_compatibility($read_pref);
+        push @candidates, $self->all_servers unless @candidates;
+        my $selector = $self->server_selector;
+        return $self->_latency_window(
+          [ grep { $_->is_available }
+              $selector ? $selector->(@candidates) : @candidates ]
+        );
+    } );
 }
 
 sub _find_nearest_server {
     my ( $self, $read_pref, @candidates ) = @_;
-    $self->_check_staleness_compatibility($read_pref);
-    push @candidates, ( $self->_primaries, $self->_secondaries ) unless @candidates;
-    my @suitable = $self->_eligible( $read_pref, @candidates );
-    my $selector = $self->server_selector;
-    return $self->_get_server_in_latency_window(
-        [ $selector ? $selector->(@suitable) : @suitable ]
-    );
+    return $self->_select_from_window( nearest => $read_pref, \@candidates, sub {
+        $self->_check_staleness_compatibility($read_pref);
+        push @candidates, ( $self->_primaries, $self->_secondaries ) unless @candidates;
+        my @suitable = $self->_eligible( $read_pref, @candidates );
+        my $selector = $self->server_selector;
+        return $self->_latency_window(
+            [ $selector ? $selector->(@suitable) : @suitable ]
+        );
+    } );
 }
 
 sub _find_primary_server {
@@ -911,13 +1491,15 @@ sub _find_primarypreferred_server {
 
 sub _find_secondary_server {
     my ( $self, $read_pref, @candidates ) = @_;
-    $self->_check_staleness_compatibility($read_pref);
-    push @candidates, $self->_secondaries unless @candidates;
-    my @suitable = $self->_eligible( $read_pref, @candidates );
-    my $selector = $self->server_selector;
-    return $self->_get_server_in_latency_window(
-        [ $selector ? $selector->(@suitable) : @suitable ]
-    );
+    return $self->_select_from_window( secondary => $read_pref, \@candidates, sub {
+        $self->_check_staleness_compatibility($read_pref);
+        push @candidates, $self->_secondaries unless @candidates;
+        my @suitable = $self->_eligible( $read_pref, @candidates );
+        my $selector = $self->server_selector;
+        return $self->_latency_window(
+            [ $selector ? $selector->(@suitable) : @suitable ]
+        );
+    } );
 }
 
 sub _find_secondarypreferred_server {
@@ -927,7 +1509,84 @@ sub _find_secondarypreferred_server {
       || $self->_find_primary_server(@candidates);
 }
 
-sub _get_server_in_latency_window {
+# Picks a random server from the latency window that $build returns.
+# Eligibility, staleness and round trip times only change with the server
+# descriptions, so the window is kept per kind of selection and read
+# preference until the topology changes.  Selections from given candidates
+# or through a user's server_selector, which may not return the same
+# servers every time, build the window each time.
+sub _select_from_window {
+    my ( $self, $kind, $read_pref, $candidates, $build ) = @_;
+
+    my $window;
+    if ( @$candidates || $self->server_selector ) {
+        $window = [ $build->() ];
+    }
+    else {
+        my $key = $read_pref ? $kind . " " . $read_pref->_cache_key : $kind;
+        $window = $self->{_selection_cache}{$key} ||= [ $build->() ];
+    }
+
+    return $self->_pick_from_window($window);
+}
+
+# With the least_loaded policy, two distinct servers are drawn at random and
+# the one with the lower load wins, which steers operations away from a
+# member that is slow right now without herding them all onto the fastest.
+sub _pick_from_window {
+    my ( $self, $window ) = @_;
+    return $window->[0] if @$window < 2;
+
+    my $i = int( rand(@$window) );
+    return $window->[$i] unless $self->server_selection_policy eq 'least_loaded';
+
+    my $j = int( rand( @$window - 1 ) );
+    $j++ if $j >= $i;
+    my ( $x, $y ) = @{$window}[ $i, $j ];
+    return $self->_server_load($x) <= $self->_server_load($y) ? $x : $y;
+}
+
+# Expected wait for an operation: operations in flight on the server's pool,
+# plus this one, times the average operation time.  The operation average
+# fades back to the heartbeat round trip time as it ages, so a server that
+# was avoided for being slow gets tried again.
+sub _server_load {
+    my ( $self, $server ) = @_;
+    my $address   = $server->address;
+    my $pool      = $self->pools->{$address};
+    my $in_flight = $pool ? $pool->in_use_count : 0;
+
+    my $latency = $self->rtt_ewma_sec->{$address} || 0;
+    if ( my $ops = $self->op_latency_ewma->{$address} ) {
+        my $weight = exp( ( $ops->[1] - time ) / OP_LATENCY_DECAY_SEC );
+        $latency = $weight * $ops->[0] + ( 1 - $weight ) * $latency;
+    }
+
+    return ( $in_flight + 1 ) * $latency;
+}
+
+sub _record_op_latency {
+    my ( $self, $link ) = @_;
+    my $now     = time;
+    my $elapsed = $now - $link->op_started;
+    $link->_clear_op_started;
+
+    my $ops = $self->op_latency_ewma->{ $link->address };
+    my $alpha = $self->ewma_alpha;
+    $self->op_latency_ewma->{ $link->address } = [
+        $ops ? $alpha * $elapsed + ( 1 - $alpha ) * $ops->[0] : $elapsed,
+        $now,
+    ];
+    return;
+}
+
+sub _clear_selection_cache {
+    my ($self) = @_;
+    %{ $self->{_selection_cache} } = ();
+    return;
+}
+
+sub _latency_window {
     my ( $self, $servers ) = @_;
     return unless @$servers;
     return $servers->[0] if @$servers == 1;
@@ -940,10 +1599,10 @@ sub _get_server_in_latency_window {
     # lowest RTT is always in the windows
     my @in_window = shift @sorted;
 
-    # add any other servers in window and return a random one
+    # add any other servers in window
     my $max_rtt = $in_window[0]->{rtt} + $self->local_threshold_sec;
     push @in_window, grep { $_->{rtt} <= $max_rtt } @sorted;
-    return $in_window[ int( rand(@in_window) ) ]->{server};
+    return map { $_->{server} } @in_window;
 }
 
 my $PRIMARY = MongoDB::ReadPreference->new;
@@ -965,18 +1624,55 @@ sub _ping_server {
 }
 
 
+sub _get_pool {
+    my ( $self, $address ) = @_;
+    return $self->pools->{$address} ||= MongoDB::_Pool->new(
+        address           => $address,
+        max_pool_size     => $self->max_pool_size,
+        min_pool_size     => $self->min_pool_size,
+        max_idle_time_sec => $self->max_idle_time_sec,
+    );
+}
+
+# Checks out a link from the server's pool; callers must return it with
+# check_in_link when the operation is done.
 sub _get_server_link {
+    my $self = shift;
+    my $link = $self->_check_out_server_link(@_)
+      or return;
+    return $self->_prepare_link($link);
+}
+
+# readies a checked out link for the operation being dispatched
+sub _prepare_link {
+    my ( $self, $link ) = @_;
+    $link->_set_deadline( $self->{_deadline} ) if defined $self->{_deadline};
+    $link->_set_op_started(time)
+      if $self->server_selection_policy eq 'least_loaded';
+    return $link;
+}
+
+sub _check_out_server_link {
     my ( $self, $server, $method, $read_pref ) = @_;
     my $address = $server->address;
-    my $link    = $self->links->{$address};
+    my $pool    = $self->_get_pool($address);
+
+    if ( $pool->size < $pool->min_pool_size ) {
+        $self->_fill_pool( $server, $pool );
+        # filling the pool might have reset or dropped the server
+        $server = $self->servers->{$address};
+        return unless $server && $server->is_available;
+    }
 
-    # if no link, make a new connection or give up
-    $link = $self->_initialize_link($address) unless $link && $link->connected;
+    # if no idle link, make a new connection or give up
+    my $link = $pool->check_out || $self->_add_pool_link( $server, $pool );
     return unless $link;
 
-    # for idle links, refresh the server and verify validity
-    if ( time - $link->last_used > $self->socket_check_interval_sec ) {
-        return $link if $self->_ping_server;
+    # for idle links, refresh the server and verify validity; a background
+    # monitor does this out of band
+    if ( !$self->_monitor_timer && time - $link->last_used > $self->socket_check_interval_sec ) {
+        return $link if $self->_ping_server($link);
+        $self->check_in_link($link);
         $self->mark_server_unknown(
           $server, 'Lost connection with the server'
         );
@@ -986,16 +1682,66 @@ sub _get_server_link {
         $server = $self->servers->{$address}
           or return;
 
-        my $fresh_link = $self->links->{$address};
-        return $fresh_link if !$method;
-
         # verify selection criteria
-        return $self->$method( $read_pref, $server ) ? $fresh_link : undef;
+        return if $method && !$self->$method( $read_pref, $server );
+
+        $pool = $self->_get_pool($address);
+        return $pool->check_out || $self->_add_pool_link( $server, $pool );
     }
 
     return $link;
 }
 
+# Connects a link for a pool that has no idle links and returns it checked
+# out.  The first link to a server is made by _initialize_link and doubles
+# as the monitoring link.
+sub _add_pool_link {
+    my ( $self, $server, $pool ) = @_;
+    my $address = $server->address;
+
+    if ( $pool->is_full ) {
+        MongoDB::ConnectionError->throw(
+            "Connection pool for $address is exhausted (max_pool_size is "
+              . $pool->max_pool_size . ")" );
+    }
+
+    my $monitor = $self->links->{$address};
+    unless ( $monitor && $monitor->is_connected ) {
+        $self->_initialize_link($address)
+          or return;
+        return $self->_get_pool($address)->check_out;
+    }
+
+    # every connection needs a handshake to negotiate compression, but only
+    # the monitoring link updates the topology, so the reply is ignored
+    my $link = eval {
+        my $new_link = MongoDB::_Link->new( %{$self->link_options}, address => $address )->connect;
+        $self->_run_ismaster( $new_link, 1 );
+        $new_link;
+    } or do {
+        my $error = $@ || "Unknown error";
+        $self->_reset_address_to_unknown( $address, $error );
+    };
+
+    return unless $link;
+
+    $link->set_metadata($server);
+    $self->_authenticate_link( $server, $link );
+
+    return $pool->add_link($link);
+}
+
+# opens idle links until the pool holds at least min_pool_size of them
+sub _fill_pool {
+    my ( $self, $server, $pool ) = @_;
+    while ( $pool->size < $pool->min_pool_size ) {
+        my $link = $self->_add_pool_link( $server, $pool )
+          or return;
+        $pool->check_in($link);
+    }
+    return;
+}
+
 sub _initialize_link {
     my ( $self, $address ) = @_;
 
@@ -1013,9 +1759,29 @@ sub _initialize_link {
     $self->links->{$address} = $link;
     $self->_update_topology_from_link( $link, with_handshake => 1 );
 
-    # after update, server might or might not exist in the topology;
-    # if not, return nothing
+    return $self->_finish_new_link( $address, $link );
+}
+
+# after the first update from a new monitoring link, the server might or
+# might not exist in the topology; if not, return nothing
+sub _finish_new_link {
+    my ( $self, $address, $link ) = @_;
+
     return unless my $server = $self->servers->{$address};
+    return unless $link->is_connected;
+
+    $self->_authenticate_link( $server, $link );
+
+    # make the link available to operations as well
+    my $pool = $self->_get_pool($address);
+    $pool->check_in( $pool->add_link($link) ) unless $pool->is_full;
+
+    return $link;
+}
+
+sub _authenticate_link {
+    my ( $self, $server, $link ) = @_;
+    my $address = $server->address;
 
     # we have a link and the server is a valid member, so
     # try to authenticate; if authentication fails, all
@@ -1032,7 +1798,7 @@ sub _initialize_link {
         };
     }
 
-    return $link;
+    return;
 }
 
 sub _primaries {
@@ -1044,7 +1810,11 @@ sub _remove_address {
     if ( $self->current_primary &&  $self->current_primary->address eq $address ) {
         $self->_clear_current_primary;
     }
-    delete $self->$_->{$address} for qw/servers links rtt_ewma_sec/;
+    if ( my $pool = delete $self->pools->{$address} ) {
+        $pool->clear;
+    }
+    delete $self->$_->{$address} for qw/servers links rtt_ewma_sec op_latency_ewma/;
+    $self->_clear_selection_cache;
     $self->publish_server_closing( $address )
       if $self->monitoring_callback;
     return;
@@ -1060,7 +1830,12 @@ sub _reset_address_to_unknown {
     my ( $self, $address, $error, $update_time ) = @_;
     $update_time //= time;
 
+    # the pool survives the reset with a new generation, so links checked
+    # out before it are discarded when they are checked in
+    my $pool = $self->pools->{$address};
     $self->_remove_address($address);
+    $self->pools->{$address} = $pool if $pool;
+
     my $desc = $self->_add_address_as_unknown( $address, $update_time, $error );
     $self->_update_topology_from_server_desc($address, $desc);
 
@@ -1093,8 +1868,10 @@ sub _selection_timeout {
 
     my $start_time = my $loop_end_time = time();
     my $max_time = $start_time + $self->server_selection_timeout_sec;
+    my $deadline = $self->{_deadline};
+    $max_time = $deadline if defined $deadline && $deadline < $max_time;
 
-    if ( $self->next_scan_time < $start_time ) {
+    if ( $self->_scan_is_due($start_time) ) {
         $self->_set_stale(1);
     }
 
@@ -1103,7 +1880,9 @@ sub _selection_timeout {
             my $scan_ready_time = $self->last_scan_time + MIN_HEARTBEAT_FREQUENCY_SEC;
 
             # if not enough time left to wait to check; then caller throws error
-            return if !$self->server_selection_try_once && $scan_ready_time > $max_time;
+            return
+              if ( !$self->server_selection_try_once || defined $deadline )
+              && $scan_ready_time > $max_time;
 
             # loop_end_time is a proxy for time() to avoid overhead
             my $sleep_time = $scan_ready_time - $loop_end_time;
@@ -1150,6 +1929,9 @@ sub _selection_timeout {
         $self->_set_stale(1);
         $loop_end_time = time();
 
+        # the operation deadline bounds selection either way
+        return if defined $deadline && $loop_end_time > $deadline;
+
         if ( $self->server_selection_try_once ) {
             # if already tried once; then caller throws error
             return if $self->last_scan_time > $start_time;
@@ -1181,6 +1963,29 @@ sub _generate_ismaster_request {
     return [ ismaster => 1, @opts ];
 }
 
+sub _ismaster_op {
+    my ( $self, $link, $with_handshake ) = @_;
+    return MongoDB::Op::_Command->_new(
+        db_name             => 'admin',
+        query               => $self->_generate_ismaster_request( $link, $with_handshake ),
+        query_flags         => {},
+        bson_codec          => $self->bson_codec,
+        read_preference     => $PRIMARY,
+        monitoring_callback => $self->monitoring_callback,
+    );
+}
+
+sub _run_ismaster {
+    my ( $self, $link, $with_handshake ) = @_;
+
+    my $op = $self->_ismaster_op( $link, $with_handshake );
+    # just for this command, use connect timeout as socket timeout;
+    # this violates encapsulation, but requires less API modification
+    # to support this specific exception to the socket timeout
+    local $link->{socket_timeout} = $link->{connect_timeout};
+    return $op->execute( $link )->output;
+}
+
 sub _update_topology_from_link {
     my ( $self, $link, %opts ) = @_;
 
@@ -1188,22 +1993,17 @@ sub _update_topology_from_link {
       if $self->monitoring_callback;
 
     my $start_time = time;
-    my $is_master = eval {
-        my $op = MongoDB::Op::_Command->_new(
-            db_name             => 'admin',
-            query               => $self->_generate_ismaster_request( $link, $opts{with_handshake} ),
-            query_flags         => {},
-            bson_codec          => $self->bson_codec,
-            read_preference     => $PRIMARY,
-            monitoring_callback => $self->monitoring_callback,
-        );
-        # just for this command, use connect timeout as socket timeout;
-        # this violates encapsulation, but requires less API modification
-        # to support this specific exception to the socket timeout
-        local $link->{socket_timeout} = $link->{connect_timeout};
-        $op->execute( $link )->output;
-    };
-    if ( my $e = $@ ) {
+    my $is_master = eval { $self->_run_ismaster( $link, $opts{with_handshake} ) };
+
+    return $self->_update_topology_from_ismaster( $link, $start_time, $is_master, $@ );
+}
+
+# takes the outcome of an ismaster sent at $start_time: either the reply or
+# the error it failed with
+sub _update_topology_from_ismaster {
+    my ( $self, $link, $start_time, $is_master, $e ) = @_;
+
+    if ( $e ) {
         my $end_time_fail = time;
         my $rtt_sec_fail = $end_time_fail - $start_time;
         $self->publish_server_heartbeat_failed( $link, $rtt_sec_fail, $e )
@@ -1267,9 +2067,12 @@ sub _construct_compressor {
 
     for my $name (@{ $self->compressors }) {
         if (grep { $name eq $_ } @supported) {
-            return MongoDB::_Protocol::get_compressor($name, {
+            my $compressor = MongoDB::_Protocol::get_compressor($name, {
                 zlib_compression_level => $self->zlib_compression_level,
             });
+            $compressor->{min_bytes} = $self->compression_min_bytes;
+            $compressor->{stats}     = $self->_compression_stats;
+            return $compressor;
         }
     }
 
@@ -1302,6 +2105,8 @@ sub _update_topology_from_server_desc {
 
     $self->_update_ls_timeout_minutes( $new_server );
 
+    $self->_clear_selection_cache;
+
     $self->publish_new_topology_desc if $self->monitoring_callback;
 
     return $new_server;
@@ -1321,6 +2126,9 @@ sub _update_ewma {
           defined($old_avg) ? ( $alpha * $rtt_sec + ( 1 - $alpha ) * $old_avg ) : $rtt_sec;
     }
 
+    # latency windows depend on the averages
+    $self->_clear_selection_cache;
+
     return;
 }
 
@@ -1333,6 +2141,10 @@ sub _update_link_metadata {
         $self->links->{$address}->set_metadata($server);
     }
 
+    if ( my $pool = $self->pools->{$address} ) {
+        $_->set_metadata($server) for $pool->all_links;
+    }
+
     return;
 }
 
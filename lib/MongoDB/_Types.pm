@@ -63,6 +63,7 @@ use Type::Library
   ReadConcern
   ReadPreference
   ServerDesc
+  ServerSelectionPolicy
   ServerType
   SingleChar
   SingleKeyHash
@@ -188,6 +189,8 @@ class_type ReadConcern, { class => 'MongoDB::ReadConcern' };
 
 class_type ServerDesc, { class => 'MongoDB::_Server' };
 
+enum ServerSelectionPolicy, [qw/random least_loaded/];
+
 enum ServerType,
   [
     qw/Standalone Mongos PossiblePrimary RSPrimary RSSecondary RSArbiter RSOther RSGhost Unknown/
@@ -114,8 +114,11 @@ sub _build_valid_options {
             heartbeatFrequencyMS
             journal
             localThresholdMS
+            maxIdleTimeMS
+            maxPoolSize
             maxStalenessSeconds
             maxTimeMS
+            minPoolSize
             readConcernLevel
             readPreference
             readPreferenceTags
@@ -124,6 +127,7 @@ sub _build_valid_options {
             serverSelectionTryOnce
             socketCheckIntervalMS
             socketTimeoutMS
+            timeoutMS
             tlsCAFile
             tlsCertificateKeyFile
             tlsCertificateKeyFilePassword
@@ -185,8 +189,12 @@ sub _build_extra_options_validation {
       wtimeoutms => '_PositiveInt',
       connecttimeoutms => '_PositiveInt',
       localthresholdms => '_PositiveInt',
+      maxidletimems => '_PositiveInt',
+      maxpoolsize => '_PositiveInt',
+      minpoolsize => '_PositiveInt',
       serverselectiontimeoutms => '_PositiveInt',
       sockettimeoutms => '_PositiveInt',
+      timeoutms => '_PositiveInt',
       w => sub {
           my $v = shift;
           if (looks_like_number($v)) {
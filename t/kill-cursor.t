@@ -52,6 +52,9 @@ do {
     undef $results;
 };
 
+# the kill is queued and sent with the next operation on the server
+$testdb->run_command([ ping => 1 ]);
+
 my ($event) = grep {
     $_->{commandName} eq 'killCursors'
     &&
@@ -0,0 +1,81 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use utf8;
+use Test::More;
+use Test::Fatal;
+
+use BSON;
+use BSON::Types ':all';
+use Tie::IxHash;
+use MongoDB;
+use MongoDB::_Protocol;
+use MongoDB::LazyDocument;
+
+my $codec = BSON->new;
+
+my @docs = (
+    [ _id => 1, name => 'café', tags => [qw/a b/], sub => [ x => 1 ] ],
+    [ _id => 2, big => bson_int64(2**40), pi => 3.14, none => undef, re => qr/ab/i ],
+);
+
+subtest 'index_document' => sub {
+    my $bson = $codec->encode_one( $docs[1] );
+    my @elements = MongoDB::_Protocol::index_document($bson);
+    is_deeply [ map { $_->[0] } @elements ], [qw/_id big pi none re/], 'keys in order';
+    is $elements[-1][4], length($bson) - 1, 'last element ends before the terminator';
+
+    like exception { MongoDB::_Protocol::index_document( substr( $bson, 0, 10 ) ) },
+      qr/Document size incorrect/, 'truncated document';
+};
+
+subtest 'split_cursor_batch' => sub {
+    my $reply = $codec->encode_one(
+        Tie::IxHash->new(
+            cursor => Tie::IxHash->new( firstBatch => \@docs, id => bson_int64(0), ns => 'db.coll' ),
+            ok     => 1,
+        )
+    );
+    my ( $rest, $batch, $key ) = MongoDB::_Protocol::split_cursor_batch($reply);
+
+    is $key, 'firstBatch', 'batch field';
+    is_deeply $batch, [ map { $codec->encode_one($_) } @docs ], 'batch documents sliced';
+    is_deeply $codec->decode_one($rest), { cursor => { id => 0, ns => 'db.coll' }, ok => 1 },
+      'reply without the batch';
+
+    ok !MongoDB::_Protocol::split_cursor_batch( $codec->encode_one( [ ok => 1 ] ) ),
+      'nothing for replies without a cursor';
+};
+
+subtest 'lazy document' => sub {
+    my $bson = $codec->encode_one( $docs[0] );
+    my $doc = MongoDB::LazyDocument->_new( $bson, $codec );
+
+    is $doc->bson, $bson, 'raw bytes';
+    isa_ok $doc->as_raw, 'BSON::Raw';
+    is_deeply [ keys %$doc ], [qw/_id name tags sub/], 'keys in order';
+    ok exists $doc->{tags}, 'existing field';
+    ok !exists $doc->{nope}, 'missing field';
+    is $doc->{name}, 'café', 'string field';
+    is_deeply $doc->{tags}, [qw/a b/], 'array field';
+    is_deeply $doc->{sub}, { x => 1 }, 'document field';
+    is $doc->{nope}, undef, 'missing field is undef';
+    is_deeply $doc->decoded, $codec->decode_one($bson), 'decoded copy';
+
+    like exception { $doc->{name} = 'other' }, qr/read-only/, 'fields are read-only';
+};
+
+done_testing;
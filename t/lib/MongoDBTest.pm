@@ -97,6 +97,7 @@ sub build_client {
             server_selection_try_once   => 0,
             wtimeout                    => 15000,
             compressors                 => ['zlib'],
+            compression_min_bytes       => 0,
             retry_writes                => 1,
             ( $codec ? ( bson_codec => $codec ) : () ),
             %args,
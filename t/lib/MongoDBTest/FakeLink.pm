@@ -0,0 +1,100 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+package MongoDBTest::FakeLink;
+
+# Links connected over a socketpair, for unit tests that play the server's
+# side of the wire protocol by hand.
+
+use strict;
+use warnings;
+
+use Exporter 'import';
+use IO::Handle;
+use MongoDB::_Link;
+use MongoDB::_Server;
+use Socket;
+use Test::More;
+use Time::HiRes qw/time/;
+
+our @EXPORT_OK = qw(
+  fake_link
+  server_description
+  read_request
+);
+
+# Returns a connected link and the handle for the server's end of it.
+# Arguments other than these go to the link's constructor:
+#
+# * address -- defaults to localhost:27017
+# * server -- the server description for the link's metadata; defaults to
+#   a 4.2 standalone at the address
+# * rcvbuf -- defaults to 64KiB
+# * class -- a MongoDB::_Link subclass to construct instead
+#
+# The test is skipped if the socketpair can't be made.
+sub fake_link {
+    my %args    = @_;
+    my $address = delete $args{address} || 'localhost:27017';
+    my $server  = delete $args{server} || server_description($address);
+    my $rcvbuf  = delete $args{rcvbuf} || 65536;
+    my $class   = delete $args{class} || 'MongoDB::_Link';
+
+    socketpair( my $client, my $peer, AF_UNIX, SOCK_STREAM, PF_UNSPEC )
+      or plan skip_all => "socketpair: $!";
+    $_->autoflush(1) for $client, $peer;
+
+    my $link = $class->new( %args, address => $address );
+    $link->_set_fh($client);
+    $link->_set_connected(1);
+    $link->_set_rcvbuf($rcvbuf);
+    $link->_set_last_used(time);
+    $link->_set_pid($$);
+    vec( my $fdset = '', fileno($client), 1 ) = 1;
+    $link->_set_fdset($fdset);
+    $link->set_metadata($server);
+
+    return ( $link, $peer );
+}
+
+# a server description from an ismaster reply; by default that of a 4.2
+# standalone
+sub server_description {
+    my ( $address, %is_master ) = @_;
+    return MongoDB::_Server->new(
+        address          => $address,
+        last_update_time => time,
+        is_master        => {
+            ok             => 1,
+            ismaster       => 1,
+            minWireVersion => 0,
+            maxWireVersion => 8,
+            %is_master,
+        },
+    );
+}
+
+# reads one whole message from the server's end of a link
+sub read_request {
+    my ($fh) = @_;
+    sysread( $fh, my $len, 4 ) == 4 or die "short read";
+    my $want = unpack( 'l<', $len ) - 4;
+    my $rest = '';
+    while ( length $rest < $want ) {
+        sysread( $fh, $rest, $want - length $rest, length $rest ) or die "short read";
+    }
+    return $len . $rest;
+}
+
+1;
@@ -0,0 +1,114 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+package MongoDBTest::IOBackend;
+
+# An I/O backend without an event loop: timers and watchers only run when a
+# test calls run_timer or run_watchers.  The backend holds weak references to its guards, so dropping a
+# guard cancels its timer or watcher, as with a real backend.
+
+use Moo;
+use Scalar::Util qw/weaken/;
+
+has _timers => (
+    is      => 'ro',
+    default => sub { [] },
+);
+
+has _watchers => (
+    is      => 'ro',
+    default => sub { [] },
+);
+
+sub timer {
+    my ( $self, $after, $cb ) = @_;
+    my $guard = bless { after => $after, cb => $cb }, 'MongoDBTest::IOBackend::Guard';
+    push @{ $self->_timers }, $guard;
+    weaken( $self->_timers->[-1] );
+    return $guard;
+}
+
+sub watch_read {
+    my ( $self, $fh, $cb ) = @_;
+    my $guard = bless { fh => $fh, cb => $cb }, 'MongoDBTest::IOBackend::Guard';
+    push @{ $self->_watchers }, $guard;
+    weaken( $self->_watchers->[-1] );
+    return $guard;
+}
+
+# Runs the live timer with the shortest delay, the oldest of those first,
+# and returns its delay; returns nothing if no timer is left.  Time already
+# waited is ignored, so the timer order is that of a loop with no other work.
+sub run_timer {
+    my ($self) = @_;
+    my $timers = _live( $self->_timers );
+    return unless @$timers;
+
+    my $next = 0;
+    for my $i ( 1 .. $#$timers ) {
+        $next = $i if $timers->[$i]{after} < $timers->[$next]{after};
+    }
+    my ($timer) = splice( @$timers, $next, 1 );
+    $timer->{cb}->();
+    return $timer->{after};
+}
+
+# Waits up to $timeout seconds for a watched handle to become readable,
+# then calls the watchers of the readable handles.  Returns how many ran.
+sub run_watchers {
+    my ( $self, $timeout ) = @_;
+    my $watchers = _live( $self->_watchers );
+
+    my $fdset = '';
+    for my $watcher (@$watchers) {
+        my $fileno = fileno( $watcher->{fh} );
+        vec( $fdset, $fileno, 1 ) = 1 if defined $fileno;
+    }
+    return 0 unless $fdset =~ /[^\0]/;
+    select( my $ready = $fdset, undef, undef, $timeout || 0 ) > 0
+      or return 0;
+
+    # a watcher may be cancelled by one that runs before it
+    my $ran = 0;
+    for my $i ( 0 .. $#$watchers ) {
+        my $watcher = $watchers->[$i] or next;
+        my $fileno  = fileno( $watcher->{fh} );
+        next unless defined $fileno && vec( $ready, $fileno, 1 );
+        $watcher->{cb}->();
+        $ran++;
+    }
+    return $ran;
+}
+
+sub pending_timers {
+    my ($self) = @_;
+    return scalar @{ _live( $self->_timers ) };
+}
+
+sub pending_watchers {
+    my ($self) = @_;
+    return scalar @{ _live( $self->_watchers ) };
+}
+
+# drops cancelled entries, keeping the rest weak
+sub _live {
+    my ($list) = @_;
+    @$list = grep { defined } @$list;
+    weaken($_) for @$list;
+    return $list;
+}
+
+with 'MongoDB::Role::_IOBackend';
+
+1;
@@ -246,4 +246,69 @@ subtest 'split sections' => sub {
   };
 };
 
+subtest 'split sections from offset' => sub {
+  my $header = "x" x 20;
+  my $encoded = $header . "\0" . $doc . "\1>\0\0\0" ."documents\0" . $doc . $doc;
+  my @got_sections = MongoDB::_Protocol::split_sections( $encoded, length $header );
+
+  is scalar @got_sections, 2, 'two sections';
+  is $got_sections[0]->{documents}[0], $doc, 'payload 0 document sliced correctly';
+  is_deeply $got_sections[1]->{documents}, [ $doc, $doc ], 'payload 1 documents sliced correctly';
+  is length $encoded, length( $header ) + 1 + length( $doc ) + 15 + 2 * length( $doc ),
+    'message not modified';
+};
+
+subtest 'malformed sections' => sub {
+  like exception { MongoDB::_Protocol::split_sections( "\0" . substr( $doc, 0, 10 ) ) },
+    qr/Section size incorrect/, 'truncated payload 0';
+  like exception { MongoDB::_Protocol::split_sections( "\1&\0\0\0" . "documents\0" . substr( $doc, 0, 10 ) ) },
+    qr/Section size incorrect/, 'truncated payload 1';
+  like exception { MongoDB::_Protocol::decode_section( "\1\x12\0\0\0" . "documents\0" . "\0\0\0\0" ) },
+    qr/Document size incorrect/, 'zero length document';
+};
+
+subtest 'write_msg' => sub {
+  my $cmd = [
+    insert => 'collectionName',
+    documents => [ $raw_doc, $raw_doc ],
+    '$db' => 'someDatabase',
+  ];
+  my ( $msg, $request_id ) = MongoDB::_Protocol::write_msg( $codec, { more_to_come => 1 }, $cmd );
+
+  my ( $len, $msg_id, undef, $opcode, $flagbits ) = unpack 'l<5', $msg;
+  is $len, length $msg, 'message length in header';
+  is $opcode, 2013, 'OP_MSG opcode';
+  is $flagbits, 2, 'moreToCome flag set';
+  is $msg_id, $request_id, 'request ID in header';
+
+  my @got_sections = MongoDB::_Protocol::split_sections( $msg, 20 );
+  is scalar @got_sections, 2, 'two sections';
+  is $got_sections[1]->{identifier}, 'documents', 'document sequence identifier';
+  is_deeply $got_sections[1]->{documents}, [ $doc, $doc ], 'document sequence';
+
+  my $compressor = MongoDB::_Protocol::get_compressor('none');
+  my $compressed = MongoDB::_Protocol::compress( $msg, $compressor );
+  is unpack( 'l<', $compressed ), length $compressed, 'compressed message length in header';
+  is substr( MongoDB::_Protocol::try_uncompress($compressed), 4 ), substr( $msg, 4 ),
+    'compressed message round trips';
+
+  ( $msg ) = MongoDB::_Protocol::write_msg( $codec, { exhaust_allowed => 1 }, [ ping => 1, '$db' => 'admin' ] );
+  is +( unpack 'l<5', $msg )[4], 1 << 16, 'exhaustAllowed flag set';
+};
+
+subtest 'parse_reply flags' => sub {
+  my $body = " " . $doc;
+  my $reply = pack( 'l<5', 20 + length $body, 77, 5, 2013, 2 ) . $body;
+  my $result = MongoDB::_Protocol::parse_reply( $reply, 5 );
+  ok $result->{flags}{more_to_come}, 'moreToCome';
+  ok !$result->{flags}{checksum_present}, 'no checksum';
+  is $result->{request_id}, 77, 'reply request ID';
+
+  # awaitCapable | queryFailure
+  $reply = pack( 'l<4 l< q< l<2', 36, 1, 5, 1, 10, 0, 0, 0 );
+  $result = MongoDB::_Protocol::parse_reply( $reply, 5 );
+  ok $result->{flags}{query_failure}, 'queryFailure';
+  ok !$result->{flags}{cursor_not_found}, 'not cursorNotFound';
+};
+
 done_testing;
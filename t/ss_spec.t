@@ -18,6 +18,7 @@ use Test::More 0.96;
 use Test::Fatal;
 use JSON::MaybeXS;
 use Path::Tiny 0.054; # basename with suffix
+use Time::HiRes qw/time/;
 
 use MongoDB;
 use MongoDB::ReadPreference;
@@ -86,6 +87,77 @@ subtest "random selection" => sub {
     ok( $different, "servers randomly selected" );
 };
 
+subtest "cached latency window" => sub {
+
+    my $topo = create_mock_topology( "mongodb://localhost", { type => 'Sharded' } );
+    $topo->_remove_address("localhost:27017");
+
+    for my $n ( "a" .. "c" ) {
+        my $server = create_mock_server( "$n:27017", 10, type => 'Mongos' );
+        $topo->servers->{$server->address} = $server;
+        $topo->_update_ewma( $server->address, $server );
+    }
+
+    my %seen = map { ( $topo->_find_available_server->address => 1 ) } 1 .. 50;
+    is( scalar keys %seen, 3, "random selection from cached window" );
+    is_deeply( [ keys %{ $topo->_selection_cache } ], ['available'], "window cached" );
+
+    my $fast = create_mock_server( "d:27017", 0.001, type => 'Mongos' );
+    $topo->servers->{$fast->address} = $fast;
+    $topo->_update_ewma( $fast->address, $fast );
+    is( $topo->_find_available_server->address, "d:27017", "cache cleared on rtt change" );
+
+    $topo->_remove_address("d:27017");
+    isnt( $topo->_find_available_server->address, "d:27017", "cache cleared on removal" );
+};
+
+subtest "least loaded selection" => sub {
+
+    my $topo = create_mock_topology( "mongodb://localhost",
+        { type => 'Sharded', server_selection_policy => 'least_loaded' } );
+    $topo->_remove_address("localhost:27017");
+
+    for my $n ( "a", "b" ) {
+        my $server = create_mock_server( "$n:27017", 0.01, type => 'Mongos' );
+        $topo->servers->{$server->address} = $server;
+        $topo->_update_ewma( $server->address, $server );
+    }
+
+    # operations in flight on "a"
+    $topo->_get_pool("a:27017")->_in_use->{$_} = 1 for 1 .. 3;
+    my %seen = map { ( $topo->_find_available_server->address => 1 ) } 1 .. 20;
+    is_deeply( [ keys %seen ], ["b:27017"], "fewer operations in flight" );
+
+    # recent operations on "b" were slow
+    %{ $topo->_get_pool("a:27017")->_in_use } = ();
+    $topo->op_latency_ewma->{"b:27017"} = [ 0.5, time ];
+    %seen = map { ( $topo->_find_available_server->address => 1 ) } 1 .. 20;
+    is_deeply( [ keys %seen ], ["a:27017"], "faster recent operations" );
+
+    # long ago, so back to the round trip time
+    $topo->op_latency_ewma->{"b:27017"} = [ 0.5, time - 3600 ];
+    %seen = map { ( $topo->_find_available_server->address => 1 ) } 1 .. 50;
+    is( scalar keys %seen, 2, "old operation times fade" );
+};
+
+subtest "selection deadline" => sub {
+
+    my $topo = create_mock_topology( "mongodb://localhost",
+        { type => 'Sharded', server_selection_timeout_sec => 30 } );
+    $topo->_remove_address("localhost:27017");
+    $topo->_set_last_scan_time(time);
+
+    local $topo->{_deadline} = time + 0.2;
+    my $start = time;
+    ok( !$topo->_selection_timeout('_find_available_server'), "no server found" );
+    ok( time - $start < 1, "gave up at the operation deadline" );
+
+    local $topo->{_deadline} = time - 1;
+    $start = time;
+    ok( !$topo->_selection_timeout('_find_available_server'), "deadline already passed" );
+    ok( time - $start < 1, "gave up at once" );
+};
+
 subtest "server_selector" => sub {
 
     my $topo = create_mock_topology(
@@ -0,0 +1,159 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+use Test::Fatal;
+
+use BSON;
+use MongoDB;
+use MongoDB::Op::_Command;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link server_description read_request/;
+use MongoDBTest::IOBackend;
+
+my $codec   = BSON->new;
+my $address = 'localhost:27017';
+
+# a standalone that is never contacted, with one idle link over a
+# socketpair for the command to check out
+sub _setup {
+    my (%link_args) = @_;
+    my $backend = MongoDBTest::IOBackend->new;
+    my $client = MongoDB->connect( "mongodb://$address", { io_backend => $backend } );
+    my $topology = $client->_topology;
+    $topology->servers->{$address} = server_description($address);
+    $topology->_set_stale(0);
+
+    my ( $link, $server ) = fake_link( %link_args, address => $address );
+    my $pool = $topology->_get_pool($address);
+    $pool->check_in( $pool->add_link($link) );
+
+    return ( $client, $backend, $link, $server, $pool );
+}
+
+sub _reply {
+    my ( $response_to, $doc ) = @_;
+    my $body = "\0" . $codec->encode_one($doc);
+    return pack( 'l<5', 20 + length $body, 101, $response_to, 2013, 0 ) . $body;
+}
+
+sub _request_id { ( unpack( 'l<2', $_[0] ) )[1] }
+
+sub _command {
+    my ($query) = @_;
+    return MongoDB::Op::_Command->_new(
+        db_name             => 'admin',
+        query               => $query,
+        query_flags         => {},
+        bson_codec          => $codec,
+        monitoring_callback => undef,
+    );
+}
+
+# links are checked out from the pool without server selection
+{
+    no warnings 'redefine';
+    *MongoDB::_Topology::get_readable_link = sub {
+        my ($self) = @_;
+        return $self->_get_pool($address)->check_out;
+    };
+}
+
+subtest "reply" => sub {
+    my ( $client, $backend, $link, $server, $pool ) = _setup();
+
+    my @called;
+    $client->get_database('admin')
+      ->run_command_async( [ ping => 1 ], undef, undef, sub { push @called, [@_] } );
+    is( scalar @called, 0, "returns before the reply" );
+    ok( $pool->is_checked_out($link), "link held while the command is in flight" );
+
+    my $request_id = _request_id( read_request($server) );
+    is( $backend->run_watchers(0), 0, "nothing to read yet" );
+
+    syswrite( $server, _reply( $request_id, { ok => 1, pong => 1 } ) );
+    is( $backend->run_watchers(1), 1, "watcher ran" );
+    is_deeply( \@called, [ [ { ok => 1, pong => 1 }, undef ] ], "callback given the output" );
+    ok( !$pool->is_checked_out($link), "link checked in" );
+    is( $pool->idle_count, 1, "link idle again" );
+    is( $backend->pending_watchers + $backend->pending_timers, 0, "watcher and timer cancelled" );
+};
+
+subtest "reply in pieces" => sub {
+    my ( $client, $backend, $link, $server, $pool ) = _setup();
+
+    my @called;
+    $client->send_command_async( _command( [ ping => 1 ] ), 'r', sub { push @called, [@_] } );
+    my $reply = _reply( _request_id( read_request($server) ), { ok => 1 } );
+
+    syswrite( $server, substr( $reply, 0, 10 ) );
+    $backend->run_watchers(1);
+    is( scalar @called, 0, "partial reply waits for the rest" );
+
+    syswrite( $server, substr( $reply, 10 ) );
+    $backend->run_watchers(1);
+    is( scalar @called, 1, "callback called once the reply is whole" );
+    isa_ok( $called[0][0], 'MongoDB::CommandResult', "result" );
+    ok( !$pool->is_checked_out($link), "link checked in" );
+};
+
+subtest "command error" => sub {
+    my ( $client, $backend, $link, $server, $pool ) = _setup();
+
+    my @called;
+    $client->get_database('admin')
+      ->run_command_async( [ bogus => 1 ], undef, undef, sub { push @called, [@_] } );
+    my $request_id = _request_id( read_request($server) );
+    syswrite( $server, _reply( $request_id, { ok => 0, errmsg => 'no such command', code => 59 } ) );
+    $backend->run_watchers(1);
+
+    is( scalar @called, 1, "callback called" );
+    ok( !defined $called[0][0], "no output" );
+    isa_ok( $called[0][1], 'MongoDB::DatabaseError', "error" );
+    ok( $link->is_connected, "link still connected" );
+    is( $pool->idle_count, 1, "link checked in" );
+};
+
+subtest "timeout" => sub {
+    my ( $client, $backend, $link, $server, $pool ) = _setup( socket_timeout => 5 );
+
+    my @called;
+    $client->send_command_async( _command( [ ping => 1 ] ), 'r', sub { push @called, [@_] } );
+    read_request($server);
+
+    is( $backend->run_timer, 5, "socket timeout timer fired" );
+    is( scalar @called, 1, "callback called" );
+    ok( !defined $called[0][0], "no result" );
+    isa_ok( $called[0][1], 'MongoDB::NetworkTimeout', "error" );
+    ok( !$link->connected, "link closed" );
+    ok( !$pool->is_checked_out($link), "link checked in" );
+    is( $pool->size, 0, "closed link dropped from the pool" );
+    is( $client->_topology->servers->{$address}->type, 'Unknown', "server marked unknown" );
+    is( $backend->pending_watchers, 0, "watcher cancelled" );
+};
+
+subtest "no io_backend" => sub {
+    my $client = MongoDB->connect("mongodb://$address");
+    isa_ok(
+        exception { $client->send_command_async( _command( [ ping => 1 ] ), 'r', sub { } ) },
+        'MongoDB::UsageError', "send_command_async"
+    );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
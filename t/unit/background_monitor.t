@@ -0,0 +1,105 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+
+use MongoDB;
+use MongoDB::_Link;
+use MongoDB::_Server;
+use Time::HiRes qw/time/;
+
+use lib "t/lib";
+use MongoDBTest::IOBackend;
+
+my $address = 'localhost:27017';
+
+# links that look connected without a socket
+{
+    package FakeLink;
+    our @ISA = ('MongoDB::_Link');
+    sub is_connected { $_[0]->connected }
+}
+
+sub _link {
+    my $link = FakeLink->new( address => $address );
+    $link->_set_connected(1);
+    $link->_set_last_used(time);
+    return $link;
+}
+
+# a standalone that is never contacted; scans, pings and new links are
+# logged instead
+sub _topology {
+    my $client = MongoDB->connect( "mongodb://$address", { min_pool_size => 3 } );
+    my $topology = $client->_topology;
+    $topology->servers->{$address} = MongoDB::_Server->new(
+        address          => $address,
+        last_update_time => time,
+        is_master        => { ok => 1, ismaster => 1, minWireVersion => 0, maxWireVersion => 8 },
+    );
+    return ( $client, $topology );
+}
+
+subtest "pool upkeep runs one step per timer" => sub {
+    my ( $client, $topology ) = _topology();
+    my $pool = $topology->_get_pool($address);
+    my @stale = map { $pool->add_link( _link() ) } 1 .. 2;
+    $pool->check_in($_) for @stale;
+    $_->_set_last_used( time - 3600 ) for @stale;
+
+    my @log;
+    no warnings 'redefine';
+    local *MongoDB::_Topology::scan_all_servers = sub { push @log, 'scan' };
+    local *MongoDB::_Topology::_ping_server = sub {
+        my ( $self, $link ) = @_;
+        push @log, 'ping';
+        $link->_set_last_used(time);
+        return 1;
+    };
+    local *MongoDB::_Topology::_add_pool_link = sub {
+        my ( $self, $server, $pool ) = @_;
+        push @log, 'connect';
+        return $pool->add_link( _link() );
+    };
+
+    my $backend = MongoDBTest::IOBackend->new;
+    $topology->start_background_monitor($backend);
+
+    is( $backend->run_timer, 0, "scan timer fired" );
+    is_deeply( \@log, ['scan'], "scan runs alone" );
+
+    for my $step (qw/ping ping connect/) {
+        @log = ();
+        is( $backend->run_timer, 0, "upkeep timer fired" );
+        is_deeply( \@log, [$step], "one $step in the step" );
+    }
+
+    @log = ();
+    is( $backend->run_timer, 0, "last upkeep timer fired" );
+    is_deeply( \@log, [], "nothing left to do" );
+    is( $pool->size, 3, "pool filled to min_pool_size" );
+
+    is( $backend->pending_timers, 1, "only the heartbeat timer is left" );
+    is( $backend->run_timer, $topology->heartbeat_frequency_sec, "heartbeat timer fired" );
+    is_deeply( \@log, ['scan'], "next pass scans" );
+
+    $topology->stop_background_monitor;
+    is( $backend->pending_timers, 0, "stopping cancels the upkeep" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
@@ -0,0 +1,200 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+use Test::Fatal;
+
+use MongoDB;
+use MongoDB::BufferedCollection;
+use MongoDB::BulkWriteResult;
+
+# logs bulk writes and answers them with whatever the test queued
+{
+    package FakeCollection;
+    our @ISA = ('MongoDB::Collection');
+
+    sub bulk_write {
+        my ( $self, $requests, $options ) = @_;
+        push @{ $self->{log} }, [ $requests, $options ];
+        my $answer = shift @{ $self->{answers} } || sub { main::_bulk_write_result() };
+        return $answer->($requests);
+    }
+}
+
+sub _coll {
+    my $coll = MongoDB->connect->ns('db.coll');
+    return bless { %$coll, log => [], answers => [@_] }, 'FakeCollection';
+}
+
+sub _bulk_write_result {
+    return MongoDB::BulkWriteResult->new(
+        acknowledged         => 1,
+        write_errors         => [],
+        write_concern_errors => [],
+        modified_count       => 0,
+        inserted_count       => 0,
+        upserted_count       => 0,
+        matched_count        => 0,
+        deleted_count        => 0,
+        upserted             => [],
+        inserted             => [],
+        batch_count          => 1,
+        op_count             => 0,
+        @_,
+    );
+}
+
+sub _write_error {
+    my (@errors) = @_;
+    return sub {
+        MongoDB::WriteError->throw(
+            message => "whoops",
+            result  => _bulk_write_result( write_errors => \@errors ),
+        );
+    };
+}
+
+subtest "flush on count" => sub {
+    my $coll = _coll();
+    my $buffer = MongoDB::BufferedCollection->new( collection => $coll, max_ops => 3 );
+
+    $buffer->insert_one( { x => $_ } ) for 1 .. 2;
+    $buffer->delete_one( { x => 0 } );
+    is( scalar @{ $coll->{log} }, 1, "third write flushed" );
+    is( $buffer->pending, 0, "buffer empty" );
+
+    my ( $requests, $options ) = @{ $coll->{log}[0] };
+    is_deeply(
+        [ map { ref $_ eq 'ARRAY' ? ref $_->[0] || $_->[0] : $_ } @$requests ],
+        [ insert_one => 'BSON::Raw', insert_one => 'BSON::Raw', delete_one => 'HASH' ],
+        "inserts queued encoded"
+    );
+    ok( defined $requests->[1][0]{metadata}{_id}, "_id generated" );
+    is_deeply( $options, { ordered => 0 }, "unordered by default" );
+
+    $buffer->insert_one( { x => 3 } );
+    is( $buffer->pending, 1, "below the threshold" );
+    ok( $buffer->flush, "explicit flush" );
+    is( scalar @{ $coll->{log} }, 2, "second bulk write" );
+    is( $buffer->flush, undef, "nothing to flush" );
+};
+
+subtest "flush on bytes and time" => sub {
+    my $coll = _coll();
+    my $buffer = MongoDB::BufferedCollection->new( collection => $coll, max_bytes => 100 );
+    $buffer->insert_one( { x => 'a' x 40 } );
+    is( $buffer->pending, 1, "below the byte threshold" );
+    $buffer->insert_one( { x => 'a' x 40 } );
+    is( $buffer->pending, 0, "flushed at the byte threshold" );
+
+    $buffer = MongoDB::BufferedCollection->new( collection => $coll, max_delay_ms => 1 );
+    $buffer->update_one( { x => 1 }, { '$set' => { y => 1 } } );
+    select( undef, undef, undef, 0.01 );
+    $buffer->flush_due;
+    is( $buffer->pending, 0, "flushed when due" );
+};
+
+subtest "callbacks" => sub {
+    my $coll = _coll(
+        sub {
+            _bulk_write_result(
+                inserted => [ { index => 0, _id => 'a' } ],
+                upserted => [ { index => 1, _id => 'b' } ],
+            );
+        }
+    );
+    my $buffer = MongoDB::BufferedCollection->new( collection => $coll );
+
+    my @got;
+    $buffer->insert_one( { _id => 'a' }, sub { push @got, [ insert => @_ ] } );
+    $buffer->update_one( { _id => 'b' }, { '$set' => { y => 1 } }, { upsert => 1 },
+        sub { push @got, [ upsert => @_ ] } );
+    $buffer->delete_one( { _id => 'c' }, sub { push @got, [ delete => @_ ] } );
+
+    $buffer->flush;
+    is_deeply( $coll->{log}[0][0][5], [ { _id => 'c' } ], "callback not passed on" );
+    is_deeply(
+        \@got,
+        [ [ insert => undef, 'a' ], [ upsert => undef, 'b' ], [ delete => undef, undef ] ],
+        "success reported with ids"
+    ) or diag explain \@got;
+};
+
+subtest "insert options" => sub {
+    my $coll = _coll();
+    my $buffer = MongoDB::BufferedCollection->new( collection => $coll );
+
+    my @got;
+    $buffer->insert_one( { _id => 'a' }, {}, sub { push @got, $_[1] } );
+    $buffer->insert_one( { _id => 'b' }, undef, sub { push @got, $_[1] } );
+    is( $buffer->pending, 2, "empty options accepted" );
+    $buffer->flush;
+    is( scalar @got, 2, "callback after options" );
+
+    like(
+        exception { $buffer->insert_one( { _id => 'c' }, { bypassDocumentValidation => 1 } ) },
+        qr/options are not supported/,
+        "options rejected"
+    );
+    is( $buffer->pending, 0, "nothing queued" );
+};
+
+subtest "write errors" => sub {
+    my $dup = { index => 1, code => 11000, errmsg => 'duplicate key' };
+
+    my $coll = _coll( _write_error($dup) );
+    my $buffer = MongoDB::BufferedCollection->new( collection => $coll );
+    my @got;
+    $buffer->insert_one( { _id => $_ }, sub { push @got, $_[0] } ) for 1 .. 3;
+    is( exception { $buffer->flush }, undef, "error reported to callbacks only" );
+    is_deeply( \@got, [ undef, $dup, undef ], "unordered: only the failed write" );
+
+    $coll = _coll( _write_error($dup) );
+    $buffer = MongoDB::BufferedCollection->new( collection => $coll, ordered => 1 );
+    @got = ();
+    $buffer->insert_one( { _id => $_ }, sub { push @got, $_[0] } ) for 1 .. 3;
+    $buffer->flush;
+    is( $got[0], undef, "ordered: earlier write succeeded" );
+    is_deeply( $got[1], $dup, "ordered: failed write" );
+    isa_ok( $got[2], 'MongoDB::WriteError', "ordered: later write" );
+
+    $coll = _coll( _write_error($dup) );
+    $buffer = MongoDB::BufferedCollection->new( collection => $coll );
+    $buffer->insert_one( { _id => $_ } ) for 1 .. 2;
+    isa_ok( exception { $buffer->flush }, 'MongoDB::WriteError', "unreported error" );
+};
+
+subtest "failed bulk write" => sub {
+    my $coll = _coll( sub { MongoDB::NetworkError->throw("gone") } );
+    my $buffer = MongoDB::BufferedCollection->new( collection => $coll );
+    my @got;
+    $buffer->insert_one( { _id => $_ }, sub { push @got, $_[0] } ) for 1 .. 2;
+    $buffer->flush;
+    is( scalar( grep { ref $_ && $_->isa('MongoDB::NetworkError') } @got ), 2, "every write" );
+};
+
+subtest "flushed when destroyed" => sub {
+    my $coll = _coll();
+    {
+        my $buffer = MongoDB::BufferedCollection->new( collection => $coll );
+        $buffer->insert_one( { x => 1 } );
+    }
+    is( scalar @{ $coll->{log} }, 1, "flushed" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
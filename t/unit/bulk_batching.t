@@ -0,0 +1,108 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+
+use BSON;
+use MongoDB;
+use MongoDB::_Constants;
+use MongoDB::Op::_BulkWrite;
+use MongoDB::WriteConcern;
+
+# just enough of a link for batching
+{
+    package FakeLink;
+    sub new { my $class = shift; bless {@_}, $class }
+    sub supports_op_msg              { 1 }
+    sub supports_document_validation { 1 }
+    sub max_bson_object_size         { 16_777_216 }
+    sub max_message_size_bytes       { $_[0]{max_message_size_bytes} }
+}
+
+my $codec = BSON->new;
+
+sub _bulk {
+    return MongoDB::Op::_BulkWrite->_new(
+        queue               => [],
+        ordered             => 1,
+        client              => MongoDB::MongoClient->new,
+        db_name             => 'db',
+        coll_name           => 'coll',
+        full_name           => 'db.coll',
+        bson_codec          => $codec,
+        write_concern       => MongoDB::WriteConcern->new,
+        monitoring_callback => undef,
+    );
+}
+
+# collect chunks instead of sending them
+my @sent;
+{
+    no warnings 'redefine';
+    *MongoDB::Op::_BulkWrite::_execute_write_command_chunk = sub {
+        my ( $self, $link, $type, $chunk, $chunk_ops, $chunk_idx_map ) = @_;
+        push @sent, { docs => $chunk, ops => $chunk_ops, idx => $chunk_idx_map };
+    };
+}
+
+subtest "inserts cut at the exact size limit" => sub {
+    @sent = ();
+    my $limit = 1000;
+    my $link  = FakeLink->new( max_message_size_bytes => $limit + MAX_COMMAND_OVERHEAD );
+
+    my @docs = map { { _id => $_, x => "a" x ( 37 * $_ % 300 ) } } 1 .. 40;
+    _bulk()->_execute_write_command_batch( $link, [ insert => [@docs], [ 0 .. $#docs ] ] );
+
+    ok( @sent > 1, "batch was split" );
+    my @sizes = map {
+        my $total = 0;
+        $total += length $_->{bson} for @{ $_->{docs} };
+        $total
+    } @sent;
+    ok( !( grep { $_ > $limit } @sizes ), "no chunk exceeds the limit" );
+    for my $i ( 0 .. $#sent - 1 ) {
+        my $next = length $sent[ $i + 1 ]{docs}[0]{bson};
+        ok( $sizes[$i] + $next > $limit, "chunk $i is full" );
+    }
+
+    is_deeply( [ map { @{ $_->{idx} } } @sent ], [ 0 .. $#docs ], "queue indexes in order" );
+    is_deeply(
+        [ map { $_->{metadata}{_id} } map { @{ $_->{docs} } } @sent ],
+        [ map { $_->{_id} } @docs ],
+        "documents in order"
+    );
+};
+
+subtest "updates encoded once per statement" => sub {
+    @sent = ();
+    my $link = FakeLink->new( max_message_size_bytes => 16_777_216 );
+
+    my @updates = map { { q => { _id => $_ }, u => { '$set' => { x => $_ } }, multi => 0 } } 1 .. 3;
+    _bulk()->_execute_write_command_batch( $link, [ update => [@updates], [ 0 .. 2 ] ] );
+
+    is( scalar @sent, 1, "one chunk" );
+    is( ref $sent[0]{docs}[0], 'BSON::Raw', "statement sent pre-encoded" );
+    is( ref $sent[0]{ops}[0]{u}, 'BSON::Raw', "update document encoded in reported op" );
+    is_deeply(
+        $codec->decode_one( $sent[0]{docs}[2]{bson} )->{q},
+        { _id => 3 },
+        "statement round trips"
+    );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
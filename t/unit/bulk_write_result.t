@@ -0,0 +1,88 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+
+use MongoDB;
+use MongoDB::BulkWriteResult;
+
+sub _result {
+    return MongoDB::BulkWriteResult->_new(
+        modified_count       => 0,
+        write_errors         => [],
+        write_concern_errors => [],
+        op_count             => 0,
+        batch_count          => 0,
+        inserted_count       => 0,
+        upserted_count       => 0,
+        matched_count        => 0,
+        deleted_count        => 0,
+        upserted             => [],
+        inserted             => [],
+        @_,
+    );
+}
+
+# a reply to an insert of $n documents, starting at queue index $from, with
+# write errors for the given batch indexes
+sub _insert_reply {
+    my ( $from, $n, @errors ) = @_;
+    my @docs = map { bless { bson => '', metadata => { _id => $from + $_ } }, 'BSON::Raw' } 0 .. $n - 1;
+    return MongoDB::BulkWriteResult->_parse_cmd_result(
+        op       => 'insert',
+        op_count => $n,
+        result   => {
+            ok => 1,
+            n  => $n - @errors,
+            @errors
+            ? ( writeErrors => [ map { { index => $_, code => 11000, errmsg => "dup $_", op => {} } } @errors ] )
+            : (),
+        },
+        cmd_doc => [ insert => 'coll', documents => \@docs ],
+        idx_map => [ $from .. $from + $n - 1 ],
+    );
+}
+
+# as from an ordered bulk write, each batch stops at its error
+subtest "full result" => sub {
+    my $result = _result();
+    $result->_merge_result( _insert_reply( 0,  10, 9 ) );
+    $result->_merge_result( _insert_reply( 10, 10, 9 ) );
+
+    ok( !$result->is_summary, "not a summary" );
+    is( $result->inserted_count, 18, "inserted count" );
+    is( scalar @{ $result->inserted }, 18, "every _id kept" );
+    is( $result->count_write_errors, 2, "error count" );
+    is_deeply( [ map { $_->{index} } @{ $result->write_errors } ], [ 9, 19 ], "every error kept" );
+};
+
+subtest "summary result" => sub {
+    my $result = _result( _max_errors => 2 );
+    $result->_merge_result( _insert_reply( $_, 10, 9 ) ) for 0, 10, 20;
+
+    ok( $result->is_summary, "a summary" );
+    is( $result->inserted_count, 27, "inserted count" );
+    is( $result->op_count, 30, "op count" );
+    is_deeply( $result->inserted, [], "no _ids kept" );
+    is_deeply( $result->inserted_ids, {}, "no _id map" );
+    is( $result->count_write_errors, 3, "all errors counted" );
+    is_deeply( [ map { $_->{index} } @{ $result->write_errors } ], [ 9, 19 ], "first errors kept" );
+    ok( !grep( { exists $_->{op} } @{ $result->write_errors } ), "ops dropped" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
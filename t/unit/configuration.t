@@ -152,10 +152,12 @@ subtest db_name => sub {
 my %simple_time_options = (
     heartbeat_frequency_ms      => 60000,
     local_threshold_ms          => 15,
+    max_idle_time_ms            => 0,
     max_staleness_seconds           => -1,
     max_time_ms                 => 0,
     server_selection_timeout_ms => 30000,
     socket_check_interval_ms    => 5000,
+    timeout_ms                  => 0,
 );
 
 for my $key ( sort keys %simple_time_options ) {
@@ -176,6 +178,40 @@ for my $key ( sort keys %simple_time_options ) {
     };
 }
 
+subtest pool_size => sub {
+    my $mc = _mc();
+    is( $mc->max_pool_size, 100, "default max_pool_size" );
+    is( $mc->min_pool_size, 0,   "default min_pool_size" );
+
+    $mc = _mc( max_pool_size => 10, min_pool_size => 2 );
+    is( $mc->max_pool_size, 10, "max_pool_size" );
+    is( $mc->min_pool_size, 2,  "min_pool_size" );
+
+    $mc = _mc(
+        host          => 'mongodb://localhost/?maxPoolSize=20&minPoolSize=5',
+        max_pool_size => 10,
+        min_pool_size => 2,
+    );
+    is( $mc->max_pool_size, 20, "maxPoolSize" );
+    is( $mc->min_pool_size, 5,  "minPoolSize" );
+
+    like(
+        exception { _mc( max_pool_size => 2, min_pool_size => 10 ) },
+        qr/min_pool_size can't be larger than max_pool_size/,
+        "min_pool_size > max_pool_size throws"
+    );
+    like(
+        exception { _mc( host => 'mongodb://localhost/?maxPoolSize=2&minPoolSize=10' ) },
+        qr/min_pool_size can't be larger than max_pool_size/,
+        "minPoolSize > maxPoolSize throws"
+    );
+    is(
+        exception { _mc( max_pool_size => 0, min_pool_size => 10 ) },
+        undef,
+        "any min_pool_size without a max_pool_size"
+    );
+};
+
 subtest journal => sub {
     my $mc = _mc();
     ok( !$mc->j, "default j (false)" );
@@ -203,6 +239,20 @@ subtest "heartbeat frequency minimum" => sub {
     );
 };
 
+subtest "background monitoring" => sub {
+    ok( !_mc()->background_monitoring, "default background_monitoring (false)" );
+    like(
+        exception { _mc( background_monitoring => 1 ) },
+        qr/requires an io_backend/,
+        "background_monitoring without io_backend throws"
+    );
+    like(
+        exception { _mc( io_backend => 'NoSuchLoop' ) },
+        qr/Unknown io_backend/,
+        "unknown io_backend throws"
+    );
+};
+
 subtest "read_pref_mode and read_pref_tag_sets" => sub {
     my $mc = _mc();
     is( $mc->read_pref_mode, 'primary', "default read_pref_mode" );
@@ -0,0 +1,164 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+use Test::Fatal;
+use Time::HiRes qw/time usleep/;
+
+use MongoDB;
+use MongoDB::_Dispatcher;
+use MongoDB::_Link;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link server_description/;
+
+# ops that only answer what the dispatcher asks of them
+{
+    package FakeOp;
+    sub new            { my $class = shift; bless {@_}, $class }
+    sub session        { $_[0]{session} }
+    sub retryable_read { }
+    sub start          { my ( $self, $link ) = @_; $self->{start}->($link) }
+    sub finish         { my ( $self, $link ) = @_; $self->{finish}->($link) }
+    sub abandon        { 7 }
+}
+
+{
+    package FakeLink;
+    sub new                 { bless {}, shift }
+    sub supports_retryReads { 1 }
+}
+
+sub _dispatcher {
+    return MongoDB::_Dispatcher->new(
+        topology     => MongoDB->connect->_topology,
+        retry_writes => 1,
+        retry_reads  => 1,
+        @_,
+    );
+}
+
+subtest "retries stop at the deadline" => sub {
+    no warnings 'redefine';
+    my ( $links, $tries );
+    local *MongoDB::_Dispatcher::_retrieve_link_for   = sub { $links++; FakeLink->new };
+    local *MongoDB::_Dispatcher::_try_read_op_for_link = sub {
+        $tries++;
+        usleep(100_000);
+        die MongoDB::NetworkTimeout->new( message => "slow" );
+    };
+    local *MongoDB::_Dispatcher::_try_op_for_link = sub { $tries++; return "retried" };
+
+    ( $links, $tries ) = ( 0, 0 );
+    is( _dispatcher()->send_retryable_read_op( FakeOp->new ), "retried", "retried without timeout_ms" );
+    is( $tries, 2, "two attempts" );
+
+    ( $links, $tries ) = ( 0, 0 );
+    isa_ok(
+        exception { _dispatcher( timeout_sec => 0.05 )->send_retryable_read_op( FakeOp->new ) },
+        'MongoDB::NetworkTimeout', "first error thrown"
+    );
+    is( $tries, 1, "no retry after the deadline" );
+    is( $links, 1, "no second server selected" );
+};
+
+subtest "each streamed reply gets its own deadline" => sub {
+    my $dispatcher = _dispatcher( timeout_sec => 10 );
+    my $link = MongoDB::_Link->new( address => 'localhost:27017' );
+    $link->_set_deadline( time - 5 );
+
+    my $deadline;
+    my $op = FakeOp->new( finish => sub { $deadline = $_[0]->deadline; return { more_to_come => 1 } } );
+    $dispatcher->finish_direct_op( $op, $link );
+    ok( $deadline > time + 9, "deadline reset when the reply is read" );
+
+    $dispatcher = _dispatcher();
+    $dispatcher->finish_direct_op( $op, $link );
+    ok( !defined $deadline, "no deadline without timeout_ms" );
+};
+
+subtest "split ops aren't timed" => sub {
+    no warnings 'redefine';
+    my $link = MongoDB::_Link->new( address => 'localhost:27017' );
+    local *MongoDB::_Topology::get_specific_link = sub { $link->_set_op_started(time); $link };
+
+    my $op = FakeOp->new( start => sub { 1 } );
+    is( _dispatcher()->start_direct_op( $op, 'localhost:27017' ), $link, "op started" );
+    ok( !defined $link->op_started, "no latency sample for the held link" );
+};
+
+subtest "abandoned ops are drained" => sub {
+    no warnings 'redefine';
+    my @drained;
+    local *MongoDB::_Topology::drain_link = sub { shift; @drained = @_ };
+
+    my $link = MongoDB::_Link->new( address => 'localhost:27017' );
+    _dispatcher()->abandon_direct_op( FakeOp->new( session => 'session' ), $link );
+    is_deeply( \@drained, [ $link, 7, 'session' ], "link, request ID and session handed over" );
+};
+
+subtest "pipelined op errors" => sub {
+    my $address   = 'localhost:27017';
+    my $notmaster = MongoDB::NotMasterError->new(
+        message => "not master",
+        result  => MongoDB::CommandResult->_new(
+            output  => { ok => 0, code => 10107, codeName => 'NotMaster' },
+            address => $address,
+        ),
+    );
+
+    # a link to a 4.0 server, checked out from its pool
+    my $setup = sub {
+        my $dispatcher = _dispatcher();
+        my $topology   = $dispatcher->{topology};
+        $topology->servers->{$address} = server_description( $address, maxWireVersion => 7 );
+        $topology->_set_stale(0);
+        my ( $link, $server ) =
+          fake_link( address => $address, server => $topology->servers->{$address} );
+        my $pool = $topology->_get_pool($address);
+        $pool->add_link($link);
+        return ( $dispatcher, $topology, $link, $server, $pool );
+    };
+
+    no warnings 'redefine';
+    my $link;
+    local *MongoDB::_Dispatcher::_retrieve_link_for = sub { $link };
+
+    my ( $dispatcher, $topology, $server, $pool );
+    ( $dispatcher, $topology, $link, $server, $pool ) = $setup->();
+    {
+        local *MongoDB::Op::_Command::execute_pipelined = sub { ( "ok", $notmaster ) };
+        is_deeply( [ $dispatcher->send_pipelined_ops( [ map { FakeOp->new } 1 .. 2 ] ) ],
+            [ "ok", $notmaster ], "results returned" );
+    }
+    is( $topology->servers->{$address}->type, 'Unknown', "server marked unknown on NotMaster" );
+    ok( $topology->stale, "topology stale on NotMaster" );
+    ok( !$pool->is_checked_out($link), "link checked in" );
+
+    ( $dispatcher, $topology, $link, $server, $pool ) = $setup->();
+    {
+        local *MongoDB::Op::_Command::execute_pipelined =
+          sub { die MongoDB::NetworkTimeout->new( message => "slow" ) };
+        isa_ok( exception { $dispatcher->send_pipelined_ops( [ map { FakeOp->new } 1 .. 2 ] ) },
+            'MongoDB::NetworkTimeout', "network error thrown" );
+    }
+    is( $topology->servers->{$address}->type, 'Unknown', "server marked unknown on a network error" );
+    ok( !$pool->is_checked_out($link), "link checked in" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
@@ -0,0 +1,82 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+use Test::Fatal;
+use Config;
+
+use BSON;
+use MongoDB;
+use MongoDB::_EncodePipeline;
+
+plan skip_all => "needs a real fork" unless $Config{d_fork};
+
+my $codec = BSON->new;
+
+sub _pipeline {
+    my (@docs) = @_;
+    return MongoDB::_EncodePipeline->new(
+        bson_codec    => $codec,
+        docs          => \@docs,
+        workers       => 3,
+        chunk_size    => 100,
+        max_bson_size => 16_777_216,
+    )->start;
+}
+
+subtest "documents in order" => sub {
+    my @docs = map { { ( $_ % 2 ? ( _id => $_ ) : () ), x => "a" x ( $_ % 50 ) } } 1 .. 1050;
+    my $pipeline = _pipeline(@docs);
+
+    my @got;
+    for my $n ( 1, 99, 250, 1000 ) {
+        push @got, $pipeline->take($n);
+    }
+    is( scalar @got, scalar @docs, "every document" );
+    is_deeply( [ $pipeline->take(1) ], [], "nothing left" );
+
+    my @mismatch = grep {
+        my $decoded = $codec->decode_one( $got[$_]{bson} );
+        $decoded->{x} ne $docs[$_]{x}
+          || "$decoded->{_id}" ne "$got[$_]{metadata}{_id}"
+          || ( defined $docs[$_]{_id} && $decoded->{_id} != $docs[$_]{_id} )
+    } 0 .. $#docs;
+    is_deeply( \@mismatch, [], "encoded with their _id" );
+
+    my %ids = map { ( "$_->{metadata}{_id}" => 1 ) } @got;
+    is( scalar keys %ids, scalar @docs, "generated _ids unique across workers" );
+};
+
+subtest "encoding errors" => sub {
+    my @docs = map { { x => $_ } } 1 .. 300;
+    $docs[150] = { 'a.b' => 1 };
+    my $pipeline = _pipeline(@docs);
+
+    my @got = $pipeline->take(100);
+    is( scalar @got, 100, "chunk before the bad document" );
+    like( exception { $pipeline->take(1) }, qr/a\.b/, "error thrown when read" );
+};
+
+subtest "stopped early" => sub {
+    my $pipeline = _pipeline( map { { x => $_ } } 1 .. 1000 );
+    $pipeline->take(10);
+    $pipeline->finish;
+    is( scalar @{ $pipeline->_workers }, 0, "workers reaped" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
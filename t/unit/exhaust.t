@@ -0,0 +1,115 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+use Test::Fatal;
+
+use BSON;
+use BSON::Types ':all';
+use MongoDB;
+use MongoDB::Op::_GetMore;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link read_request/;
+
+my $codec = BSON->new;
+
+sub _reply {
+    my ( $id, $response_to, $more_to_come, $cursor_id, @docs ) = @_;
+    my $body = "\0"
+      . $codec->encode_one(
+        [
+            cursor => [ nextBatch => \@docs, id => bson_int64($cursor_id), ns => 'db.coll' ],
+            ok     => 1
+        ]
+      );
+    return pack( 'l<5', 20 + length $body, $id, $response_to, 2013, $more_to_come ? 2 : 0 )
+      . $body;
+}
+
+sub _get_more {
+    return MongoDB::Op::_GetMore->_new(
+        full_name           => 'db.coll',
+        db_name             => 'db',
+        coll_name           => 'coll',
+        bson_codec          => $codec,
+        cursor_id           => 42,
+        batch_size          => 2,
+        exhaust             => 1,
+        monitoring_callback => undef,
+        @_,
+    );
+}
+
+subtest "streamed batches" => sub {
+    my ( $link, $server ) = fake_link();
+    my $op = _get_more();
+
+    ok( $op->start($link), "getMore sent" );
+    my $request = read_request($server);
+    my ( undef, $request_id, undef, undef, $flags ) = unpack( 'l<5', $request );
+    is( $flags, 1 << 16, "exhaustAllowed set" );
+
+    syswrite( $server,
+        join( '',
+            _reply( 101, $request_id, 1, 42, { x => 1 }, { x => 2 } ),
+            _reply( 102, 101,         1, 42, { x => 3 }, { x => 4 } ),
+            _reply( 103, 102,         0, 0,  { x => 5 } ) ) );
+
+    my @batches;
+    while (1) {
+        my $res = $op->finish($link);
+        push @batches, [ map { $_->{x} } @{ $res->{docs} } ];
+        if ( $res->{more_to_come} ) {
+            ok( $op->is_streaming, "streaming after batch " . scalar @batches );
+            next;
+        }
+        is( $res->{cursor_id}, 0, "cursor exhausted" );
+        last;
+    }
+
+    is_deeply( \@batches, [ [ 1, 2 ], [ 3, 4 ], [5] ], "all batches from one request" );
+    ok( !$op->is_streaming, "stream finished" );
+};
+
+subtest "reply to the wrong message" => sub {
+    my ( $link, $server ) = fake_link();
+    my $op = _get_more();
+
+    $op->start($link);
+    my ( undef, $request_id ) = unpack( 'l<2', read_request($server) );
+    syswrite( $server,
+        join( '', _reply( 101, $request_id, 1, 42, { x => 1 } ), _reply( 102, 999, 0, 0 ) ) );
+
+    ok( $op->finish($link)->{more_to_come}, "first batch" );
+    like( exception { $op->finish($link) }, qr/did not match request ID/, "responseTo checked" );
+};
+
+subtest "no exhaust before 4.2" => sub {
+    my ( $link, $server ) = fake_link();
+    $link->_set_supports_exhaust_allowed(0);
+    my $op = _get_more();
+
+    $op->start($link);
+    my ( undef, $request_id, undef, undef, $flags ) = unpack( 'l<5', read_request($server) );
+    is( $flags, 0, "exhaustAllowed not set" );
+    syswrite( $server, _reply( 101, $request_id, 0, 42, { x => 1 } ) );
+    ok( !$op->finish($link)->{more_to_come}, "single batch" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
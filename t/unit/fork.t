@@ -0,0 +1,66 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+
+use MongoDB;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link/;
+
+# each test pretends to run in a forked child by changing the recorded PID
+
+subtest "topology drops inherited links" => sub {
+    my $topology = MongoDB->connect('mongodb://localhost')->_topology;
+    my $address  = 'localhost:27017';
+
+    my ( $link, $peer ) = fake_link( address => $address );
+
+    my $pool = $topology->_get_pool($address);
+    $pool->check_in( $pool->add_link($link) );
+    $topology->links->{$address} = $link;
+    my $server = $topology->servers->{$address};
+
+    $topology->{_pid} = $$ + 1;
+    $topology->_check_for_fork;
+    is( $topology->{_pid}, $$, "PID updated" );
+    ok( !$link->is_connected, "inherited link closed" );
+    is_deeply( $topology->pools, {}, "pools dropped" );
+    is_deeply( $topology->links, {}, "monitoring links dropped" );
+    is( $topology->servers->{$address}, $server, "server descriptions kept" );
+};
+
+subtest "session pool reset" => sub {
+    my $client   = MongoDB->connect('mongodb://localhost');
+    my $sessions = $client->_server_session_pool;
+    $client->_topology->_set_logical_session_timeout_minutes(30);
+
+    my $session = $sessions->get_server_session;
+    $sessions->retire_server_session($session);
+    is( $sessions->get_server_session, $session, "session reused in the same process" );
+    $sessions->retire_server_session($session);
+
+    $sessions->{_pid} = $$ + 1;
+    isnt( $sessions->get_server_session, $session, "inherited session not reused" );
+    is( $sessions->_pool_epoch, 1, "pool epoch bumped" );
+
+    $sessions->retire_server_session($session);
+    is( scalar @{ $sessions->_server_session_pool }, 0, "inherited session not checked in" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
@@ -0,0 +1,282 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+use Test::Fatal;
+
+use BSON;
+use BSON::Types ':all';
+use MongoDB;
+use MongoDB::_Constants;
+use MongoDB::_Dispatcher;
+use MongoDB::_Server;
+use MongoDB::Op::_Query;
+use Time::HiRes qw/time/;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link server_description read_request/;
+
+my $codec = BSON->new;
+my @hosts = qw/localhost:27017 localhost:27018/;
+
+# a replica set of two secondaries that is never contacted; links are made
+# by hand below
+sub _client {
+    my $client = MongoDB->connect(
+        "mongodb://" . join( ",", @hosts ) . "/?replicaSet=rs&readPreference=secondaryPreferred" );
+    my $topology = $client->_topology;
+    $topology->servers->{$_} = _server($_) for @hosts;
+    return $client;
+}
+
+sub _server {
+    my ($address) = @_;
+    return server_description(
+        $address,
+        ismaster  => 0,
+        secondary => 1,
+        setName   => 'rs',
+        hosts     => \@hosts,
+    );
+}
+
+# a link checked out from the pool for $address, and the server's end of it
+sub _link_and_server {
+    my ( $topology, $address, %args ) = @_;
+    my ( $link, $server ) =
+      fake_link( %args, address => $address, server => $topology->servers->{$address} );
+    $topology->_get_pool($address)->add_link($link);
+    return ( $link, $server );
+}
+
+# an idle pooled link for $address to hedge onto
+sub _idle_link_and_server {
+    my ( $topology, $address ) = @_;
+    my ( $link, $server ) = _link_and_server( $topology, $address );
+    $topology->check_in_link($link);
+    return ( $link, $server );
+}
+
+# answers the next find on $fh with a cursor
+sub _answer {
+    my ( $fh, $cursor_id, @docs ) = @_;
+    my ( undef, $request_id ) = unpack( 'l<2', read_request($fh) );
+    my $body = "\0"
+      . $codec->encode_one(
+        [
+            cursor => [ firstBatch => \@docs, id => bson_int64($cursor_id), ns => 'db.coll' ],
+            ok     => 1
+        ]
+      );
+    syswrite( $fh, pack( 'l<5', 20 + length $body, $request_id + 1, $request_id, 2013, 0 ) . $body );
+    return;
+}
+
+sub _query {
+    my ($client) = @_;
+    return MongoDB::Op::_Query->_new(
+        filter  => {},
+        options => MongoDB::Op::_Query->precondition_options( {} ),
+        session => undef,
+        %{ $client->ns('db.coll')->_op_args },
+    );
+}
+
+# with $delay, the first server has enough read times for that hedge delay
+sub _dispatcher {
+    my ( $client, $delay ) = @_;
+    my $dispatcher = MongoDB::_Dispatcher->new(
+        topology     => $client->_topology,
+        retry_writes => 1,
+        retry_reads  => 1,
+    );
+    $dispatcher->{_read_times}{ $hosts[0] } = [ ($delay) x HEDGE_MIN_SAMPLES ]
+      if defined $delay;
+    return $dispatcher;
+}
+
+subtest "reply before the hedge delay" => sub {
+    my $client   = _client();
+    my $topology = $client->_topology;
+    my ( $link, $server ) = _link_and_server( $topology, $hosts[0] );
+    my ( $idle, $idle_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    my $dispatcher = _dispatcher( $client, 5 );
+
+    no warnings 'redefine';
+    my $wait = \&MongoDB::_Topology::_wait_readable;
+    my $answered;
+    local *MongoDB::_Topology::_wait_readable = sub {
+        _answer( $server, 0, { x => 1 } ) unless $answered++;
+        goto &$wait;
+    };
+
+    my $result = $dispatcher->_try_hedged_read( $link, _query($client) );
+    is_deeply( [ $result->all ], [ { x => 1 } ], "reply read" );
+    is( $topology->_get_pool( $hosts[1] )->idle_count, 1, "no hedge sent" );
+    is( $topology->_get_pool( $hosts[0] )->idle_count, 1, "link checked in" );
+    is( scalar @{ $dispatcher->{_read_times}{ $hosts[0] } },
+        HEDGE_MIN_SAMPLES + 1, "read time recorded" );
+};
+
+subtest "hedge reply wins" => sub {
+    my $client   = _client();
+    my $topology = $client->_topology;
+    my ( $link, $server ) = _link_and_server( $topology, $hosts[0] );
+    my ( $idle, $hedge_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    my $dispatcher = _dispatcher( $client, 0.1 );
+
+    no warnings 'redefine';
+    my $start_hedge = \&MongoDB::_Dispatcher::_start_hedge;
+    my $hedged_at;
+    local *MongoDB::_Dispatcher::_start_hedge = sub {
+        $hedged_at = time;
+        my $hedge = $start_hedge->(@_);
+        _answer( $hedge_server, 0, { x => 2 } );
+        return $hedge;
+    };
+
+    my $start  = time;
+    my $result = $dispatcher->_try_hedged_read( $link, _query($client) );
+    # select may wake a little early
+    ok( $hedged_at - $start >= 0.09, "hedge sent after the delay" );
+    is_deeply( [ $result->all ], [ { x => 2 } ], "hedge reply returned" );
+    is( $result->_address, $hosts[1], "result from the hedge server" );
+    is( $topology->_get_pool( $hosts[1] )->idle_count, 1, "hedge link checked in" );
+
+    my $pool = $topology->_get_pool( $hosts[0] );
+    ok( $pool->is_checked_out($link), "first link held" );
+    is( scalar @{ $topology->_draining }, 1, "first link draining" );
+
+    _answer( $server, 77, { x => 1 } );
+    $topology->_poll_draining;
+    is( scalar @{ $topology->_draining }, 0, "late reply drained" );
+    is( $pool->idle_count, 1, "drained link checked in" );
+    my ($kill) = $topology->_kill_queue->take( $hosts[0] );
+    ok( $kill, "drained cursor queued for kill" );
+    is( $kill && $kill->cursor_ids->[0], 77, "cursor ID from the late reply" );
+};
+
+subtest "first reply wins after the hedge" => sub {
+    my $client   = _client();
+    my $topology = $client->_topology;
+    my ( $link, $server ) = _link_and_server( $topology, $hosts[0] );
+    my ( $idle, $hedge_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    my $dispatcher = _dispatcher( $client, 0.1 );
+
+    no warnings 'redefine';
+    my $start_hedge = \&MongoDB::_Dispatcher::_start_hedge;
+    local *MongoDB::_Dispatcher::_start_hedge = sub {
+        my $hedge = $start_hedge->(@_);
+        _answer( $server, 0, { x => 1 } );
+        return $hedge;
+    };
+
+    my $result = $dispatcher->_try_hedged_read( $link, _query($client) );
+    is_deeply( [ $result->all ], [ { x => 1 } ], "first reply returned" );
+    is( $topology->_get_pool( $hosts[0] )->idle_count, 1, "first link checked in" );
+    is( scalar @{ $topology->_draining }, 1, "hedge link draining" );
+
+    _answer( $hedge_server, 88, { x => 2 } );
+    $topology->_poll_draining;
+    is( $topology->_get_pool( $hosts[1] )->idle_count, 1, "drained hedge link checked in" );
+    is( $topology->_kill_queue->count( $hosts[1] ), 1, "hedge cursor queued for kill" );
+};
+
+subtest "both sides fail" => sub {
+    my $client   = _client();
+    my $topology = $client->_topology;
+    my ( $link, $server ) = _link_and_server( $topology, $hosts[0] );
+    my ( $idle, $hedge_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    my $dispatcher = _dispatcher( $client, 0.1 );
+
+    no warnings 'redefine';
+    my $start_hedge = \&MongoDB::_Dispatcher::_start_hedge;
+    local *MongoDB::_Dispatcher::_start_hedge = sub {
+        my $hedge = $start_hedge->(@_);
+        close $_ for $server, $hedge_server;
+        return $hedge;
+    };
+
+    isa_ok(
+        exception { $dispatcher->_try_hedged_read( $link, _query($client) ) },
+        'MongoDB::NetworkError', "error thrown"
+    );
+    ok( !$_->is_connected, "link closed" ) for $link, $idle;
+    is( $topology->servers->{$_}->type, 'Unknown', "$_ marked unknown" ) for @hosts;
+    is( $topology->_get_pool($_)->in_use_count, 0, "$_ link checked in" ) for @hosts;
+    is( scalar @{ $topology->_draining }, 0, "nothing left to drain" );
+};
+
+subtest "timeout" => sub {
+    my $client   = _client();
+    my $topology = $client->_topology;
+    my ( $link, $server ) = _link_and_server( $topology, $hosts[0], socket_timeout => 0.3 );
+    my ( $idle, $hedge_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    my $dispatcher = _dispatcher( $client, 0.1 );
+
+    isa_ok(
+        exception { $dispatcher->_try_hedged_read( $link, _query($client) ) },
+        'MongoDB::NetworkTimeout', "socket timeout"
+    );
+    ok( !$_->is_connected, "link closed" ) for $link, $idle;
+    is( $topology->servers->{$_}->type, 'Unknown', "$_ marked unknown" ) for @hosts;
+    is( $topology->_get_pool($_)->in_use_count, 0, "$_ link checked in" ) for @hosts;
+    is( scalar @{ $topology->_draining }, 0, "nothing left to drain" );
+
+    $client   = _client();
+    $topology = $client->_topology;
+    ( $link, $server ) = _link_and_server( $topology, $hosts[0] );
+    ( $idle, $hedge_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    $dispatcher = _dispatcher( $client, 0.1 );
+    $link->_set_deadline( time + 0.3 );
+
+    isa_ok(
+        exception { $dispatcher->_try_hedged_read( $link, _query($client) ) },
+        'MongoDB::ExecutionTimeout', "operation deadline"
+    );
+    ok( !$_->is_connected, "link closed" ) for $link, $idle;
+    is( $topology->servers->{$_}->type, 'RSSecondary', "$_ not marked unknown" ) for @hosts;
+};
+
+subtest "get_hedge_link" => sub {
+    my $client   = _client();
+    my $topology = $client->_topology;
+    my $op       = _query($client);
+
+    ok( !$topology->get_hedge_link( $op, $hosts[0] ), "none without an idle link" );
+    ok( !$topology->pools->{ $hosts[1] }, "no link opened" );
+
+    my ( $mine, $mine_server ) = _idle_link_and_server( $topology, $hosts[0] );
+    ok( !$topology->get_hedge_link( $op, $hosts[0] ), "not onto the first server" );
+
+    my ( $idle, $idle_server ) = _idle_link_and_server( $topology, $hosts[1] );
+    {
+        local $topology->{_deadline} = time + 10;
+        my $hedge = $topology->get_hedge_link( $op, $hosts[0] );
+        is( $hedge, $idle, "idle link on the other server" );
+        ok( $topology->_get_pool( $hosts[1] )->is_checked_out($idle), "link checked out" );
+        ok( defined $idle->deadline, "operation deadline applied" );
+        $topology->check_in_link($idle);
+    }
+
+    $topology->servers->{ $hosts[1] } =
+      MongoDB::_Server->new( address => $hosts[1], last_update_time => time );
+    ok( !$topology->get_hedge_link( $op, $hosts[0] ), "none onto an unknown server" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
@@ -0,0 +1,165 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+
+use BSON;
+use MongoDB;
+use MongoDB::Op::_KillCursors;
+use Time::HiRes qw/time/;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link server_description/;
+
+my $class = "MongoDB::_KillCursorsQueue";
+
+require_ok($class);
+
+# sessions that need no server
+{
+    package FakeSession;
+    our @ISA = ('MongoDB::ClientSession');
+    sub _end_session { }
+}
+
+sub _op {
+    my ( $full_name, @ids ) = @_;
+    my $session = ref $ids[0] ? shift @ids : undef;
+    my ( $db_name, $coll_name ) = split /\./, $full_name, 2;
+    return MongoDB::Op::_KillCursors->_new(
+        db_name             => $db_name,
+        coll_name           => $coll_name,
+        full_name           => $full_name,
+        bson_codec          => BSON->new,
+        cursor_ids          => [@ids],
+        monitoring_callback => undef,
+        session             => $session,
+    );
+}
+
+subtest "grouped by server and namespace" => sub {
+    my $queue = new_ok($class);
+    $queue->add( 'a:27017', _op( 'db.one', 1 ) );
+    $queue->add( 'a:27017', _op( 'db.two', 2 ) );
+    $queue->add( 'a:27017', _op( 'db.one', 3 ) );
+    $queue->add( 'b:27017', _op( 'db.one', 4 ) );
+
+    is( $queue->count('a:27017'), 3, "count per server" );
+
+    my %ops = map { $_->full_name => $_ } $queue->take('a:27017');
+    is_deeply( [ sort keys %ops ], [qw/db.one db.two/], "one op per namespace" );
+    is_deeply( $ops{'db.one'}->cursor_ids, [ 1, 3 ], "IDs merged" );
+    is_deeply( $ops{'db.two'}->cursor_ids, [2], "IDs kept apart by namespace" );
+
+    is( $queue->count('a:27017'), 0, "taken IDs are removed" );
+    is( $queue->count('b:27017'), 1, "other servers untouched" );
+    is_deeply( [ $queue->take('c:27017') ], [], "nothing for unknown server" );
+};
+
+subtest "grouped by session" => sub {
+    my $queue = new_ok($class);
+    my @sessions = map { bless {}, 'FakeSession' } 1 .. 2;
+    $queue->add( 'a:27017', _op( 'db.one', $sessions[0], 1 ) );
+    $queue->add( 'a:27017', _op( 'db.one', $sessions[1], 2 ) );
+    $queue->add( 'a:27017', _op( 'db.one', $sessions[0], 3 ) );
+
+    my @ops = sort { $a->cursor_ids->[0] <=> $b->cursor_ids->[0] } $queue->take('a:27017');
+    is( scalar @ops, 2, "one op per session" );
+    is_deeply( $ops[0]->cursor_ids, [ 1, 3 ], "IDs merged within a session" );
+    is( $ops[0]->session, $sessions[0], "session kept" );
+    is( $ops[1]->session, $sessions[1], "other session kept apart" );
+};
+
+subtest "take_session" => sub {
+    my $queue = new_ok($class);
+    my @sessions = map { bless {}, 'FakeSession' } 1 .. 2;
+    $queue->add( 'a:27017', _op( 'db.one', $sessions[0], 1, 2 ) );
+    $queue->add( 'a:27017', _op( 'db.one', $sessions[1], 3 ) );
+    $queue->add( 'b:27017', _op( 'db.two', $sessions[0], 4 ) );
+
+    my %taken = map { $_->[0] => $_->[1] } $queue->take_session( $sessions[0] );
+    is_deeply( [ sort keys %taken ], [qw/a:27017 b:27017/], "ops from every server" );
+    is_deeply( $taken{'a:27017'}->cursor_ids, [ 1, 2 ], "IDs of the session" );
+    is( $queue->count('a:27017'), 1, "other session left" );
+    is( $queue->count('b:27017'), 0, "count reduced" );
+    is_deeply( [ $queue->due( time + 100 ) ], ['a:27017'], "emptied server dropped" );
+};
+
+subtest "sent when the session ends" => sub {
+    my $client = MongoDB->connect('mongodb://localhost');
+    $client->_topology->_set_logical_session_timeout_minutes(30);
+    my $session = $client->_start_client_session(1);
+    $client->_topology->defer_kill_cursors( 'localhost:27017', _op( 'db.coll', $session, 1 ) );
+
+    no warnings 'redefine';
+    my @sent;
+    local *MongoDB::MongoClient::send_direct_op = sub {
+        my ( $self, $op, $address ) = @_;
+        push @sent, [ $address, $op->cursor_ids, defined $op->session->_server_session ];
+    };
+
+    $session->end_session;
+    is_deeply( \@sent, [ [ 'localhost:27017', [1], 1 ] ], "kill sent before the session ended" );
+    is( $client->_topology->_kill_queue->count('localhost:27017'), 0, "queue emptied" );
+    ok( !defined $session->_server_session, "session ended" );
+};
+
+subtest "due" => sub {
+    my $queue = new_ok( $class, [ max_cursors => 3, max_age_sec => 10 ] );
+    $queue->add( 'a:27017', _op( 'db.coll', 1, 2 ) );
+    $queue->add( 'b:27017', _op( 'db.coll', 3 ) );
+    is_deeply( [ $queue->due(time) ], [], "nothing due" );
+
+    $queue->add( 'a:27017', _op( 'db.other', 4 ) );
+    is_deeply( [ $queue->due(time) ], ['a:27017'], "due by count" );
+
+    is_deeply( [ sort $queue->due( time + 10 ) ], [qw/a:27017 b:27017/], "due by age" );
+};
+
+subtest "flushed only onto idle links" => sub {
+    my $topology = MongoDB->connect('mongodb://localhost')->_topology;
+    my $address  = 'localhost:27017';
+    $topology->servers->{$address} = server_description($address);
+    $topology->{_kill_queue} = $class->new( max_cursors => 1 );
+
+    no warnings 'redefine';
+    my @sent;
+    local *MongoDB::_Topology::_send_queued_kills = sub {
+        push @sent, $_[1];
+        $_[0]{_kill_queue}->take( $_[1]->address );
+    };
+    local *MongoDB::_Topology::_get_server_link = sub { die "connected" };
+
+    $topology->defer_kill_cursors( $address, _op( 'db.coll', 1 ) );
+    is( $topology->{_kill_queue}->count($address), 1, "kept without an idle link" );
+
+    my ( $link, $peer ) = fake_link( address => $address );
+    my $pool = $topology->_get_pool($address);
+    $pool->check_in( $pool->add_link($link) );
+
+    $topology->defer_kill_cursors( $address, _op( 'db.coll', 2 ) );
+    is_deeply( \@sent, [$link], "sent on the idle link" );
+    is( $topology->{_kill_queue}->count($address), 0, "queue flushed" );
+    is( $pool->idle_count, 1, "link back in the pool" );
+
+    delete $topology->servers->{$address};
+    $topology->defer_kill_cursors( $address, _op( 'db.coll', 3 ) );
+    is( $topology->{_kill_queue}->count($address), 0, "dropped once the server is gone" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
@@ -17,9 +17,16 @@ use warnings;
 use Test::More 0.88;
 use Test::Fatal;
 
+use BSON;
 use MongoDB::_Server;
+use MongoDB::Op::_Command;
+use MongoDB::_CompressionStats;
+use MongoDB::_Protocol;
 use Time::HiRes qw/time/;
 
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link/;
+
 my $class = "MongoDB::_Link";
 
 require_ok( $class );
@@ -48,5 +55,194 @@ is( $obj->max_message_size_bytes, 2*4*1024*1024, "default max message size" );
     );
 }
 
+subtest "compression thresholds" => sub {
+    my $stats      = MongoDB::_CompressionStats->new( probe_interval => 4 );
+    my $compressor = MongoDB::_Protocol::get_compressor('zlib');
+    @{$compressor}{qw/min_bytes stats/} = ( 1024, $stats );
+
+    my $link = $class->new( address => 'localhost:27017' );
+    $link->set_metadata(
+        MongoDB::_Server->new(
+            address          => 'localhost:27017',
+            last_update_time => time,
+            compressor       => $compressor,
+        )
+    );
+
+    my $msg = sub { pack( "l<4", 16 + length $_[0], 1, 0, 2013 ) . $_[0] };
+    my $compressed = sub {
+        ( unpack( "l<4", $link->_prepare_write( $msg->( $_[0] ), { command_name => $_[1] } ) ) )[3]
+          == 2012;
+    };
+
+    ok( !$compressed->( "a" x 100, 'find' ), "small message sent as is" );
+    ok( $compressed->( "a" x 5000, 'find' ), "large message compressed" );
+
+    my $noise = join '', map { chr int rand 256 } 1 .. 5000;
+    ok( !$compressed->( $noise, 'insert' ), "sent as is when compression doesn't help" );
+    ok( $stats->ratio('insert') > 1, "ratio tracked" );
+    ok( !$stats->should_compress('insert'), "insert no longer compressed" );
+    ok( $stats->should_compress('find'), "find still compressed" );
+    is( scalar( grep { $stats->should_compress('insert') } 1 .. 8 ), 2, "probed now and then" );
+};
+
+subtest "pipelined replies" => sub {
+    my ( $link, $server ) = fake_link( server => $dummy_server );
+
+    # two replies, out of order, delivered in a single write
+    my @replies = map {
+        my $body = "x" x $_;
+        pack( "l<4", 16 + length($body), 0, $_, 1 ) . $body
+    } 20, 10;
+    syswrite( $server, join( '', @replies ) );
+
+    my $got = $link->read_replies( [ 10, 20 ] );
+    is( $got->{10}, $replies[1], "reply matched to first request" );
+    is( $got->{20}, $replies[0], "reply matched to second request" );
+    is( MongoDB::_Protocol::get_response_to( $got->{20} ), 20, "responseTo from header" );
+
+    syswrite( $server, $replies[0] );
+    like(
+        exception { $link->read_replies( [99] ) },
+        qr/did not match any pipelined request/,
+        "unexpected responseTo throws error",
+    );
+};
+
+subtest "read into reused buffer" => sub {
+    my ( $link, $server ) = fake_link( server => $dummy_server, rcvbuf => 16 );
+
+    # larger than rcvbuf, so the rest is read after the header
+    my @replies = map {
+        my $body = $_ x 40;
+        pack( "l<4", 16 + length($body), 0, 1, 1 ) . $body
+    } qw/a b/;
+    syswrite( $server, join( '', @replies ) );
+
+    my $buf = $link->reply_buffer;
+    is( $link->read($buf), $buf, "read returns the buffer reference" );
+    is( $$buf, $replies[0], "first reply read into buffer" );
+    is( $link->read( $link->reply_buffer ), $buf, "link buffer is reused" );
+    is( $$buf, $replies[1], "second reply replaces the first" );
+
+    syswrite( $server, $replies[0] );
+    is( $link->read, $replies[0], "read without a buffer returns the message" );
+
+    $link->_close;
+    ok( !defined ${ $link->reply_buffer }, "buffer released on close" );
+};
+
+subtest "read_available" => sub {
+    my ( $link, $server ) = fake_link( server => $dummy_server );
+
+    my $reply = pack( "l<4", 26, 0, 1, 1 ) . "y" x 10;
+    syswrite( $server, substr( $reply, 0, 6 ) );
+    ok( !defined $link->read_available, "partial header needs more data" );
+    syswrite( $server, substr( $reply, 6, 10 ) );
+    ok( !defined $link->read_available, "partial body needs more data" );
+    syswrite( $server, substr( $reply, 16 ) );
+    is( $link->read_available, $reply, "complete reply returned" );
+
+    close $server;
+    like(
+        exception { $link->read_available },
+        qr/Unexpected end of stream/,
+        "EOF throws error",
+    );
+};
+
+subtest "operation deadline" => sub {
+    my ( $link, $server ) = fake_link( server => $dummy_server, socket_timeout => 10 );
+
+    is( $link->_io_timeout, 10, "socket timeout without a deadline" );
+    $link->_set_deadline( time + 60 );
+    is( $link->_io_timeout, 10, "socket timeout when sooner" );
+    $link->_set_deadline( time + 0.2 );
+    ok( $link->_io_timeout <= 0.2, "capped at the time remaining" );
+    $link->_set_deadline( time - 1 );
+    is( $link->_io_timeout, 0, "never negative" );
+
+    my $command = sub {
+        MongoDB::Op::_Command->_new(
+            db_name             => 'db',
+            query               => [ find => 'coll', @_ ],
+            query_flags         => {},
+            bson_codec          => BSON->new,
+            monitoring_callback => undef,
+        );
+    };
+    isa_ok( exception { $command->()->_apply_deadline($link) },
+        'MongoDB::ExecutionTimeout', "command past the deadline" );
+
+    $link->_set_deadline( time + 5 );
+    my $op = $command->();
+    $op->_apply_deadline($link);
+    my $max_time_ms = $op->query->FETCH('maxTimeMS');
+    ok( $max_time_ms > 4000 && $max_time_ms <= 5000, "maxTimeMS from the time remaining" )
+      or diag $max_time_ms;
+
+    $op = $command->( maxTimeMS => 100 );
+    $op->_apply_deadline($link);
+    is( $op->query->FETCH('maxTimeMS'), 100, "smaller maxTimeMS kept" );
+
+    $op = $command->( maxTimeMS => 60000 );
+    $op->_apply_deadline($link);
+    ok( $op->query->FETCH('maxTimeMS') <= 5000, "larger maxTimeMS replaced" );
+
+    $op = MongoDB::Op::_Command->_new(
+        db_name             => 'db',
+        query               => [ getMore => 42, collection => 'coll' ],
+        query_flags         => {},
+        bson_codec          => BSON->new,
+        monitoring_callback => undef,
+    );
+    $op->_apply_deadline($link);
+    ok( !$op->query->FETCH('maxTimeMS'), "no maxTimeMS for getMore" );
+
+    $link->_set_deadline( time + 0.1 );
+    isa_ok( exception { $link->read }, 'MongoDB::ExecutionTimeout', "read past the deadline" );
+    ok( !$link->connected, "link closed" );
+
+    ( $link, $server ) = fake_link( server => $dummy_server, socket_timeout => 0.1 );
+    $link->_set_deadline( time + 60 );
+    isa_ok( exception { $link->read }, 'MongoDB::NetworkTimeout', "read past the socket timeout" );
+};
+
+subtest "non-blocking connect" => sub {
+    require IO::Socket::INET;
+    my $listener = IO::Socket::INET->new(
+        LocalAddr => '127.0.0.1',
+        LocalPort => 0,
+        Listen    => 1,
+        Proto     => 'tcp',
+    ) or plan skip_all => "listen: $@";
+    my $address = '127.0.0.1:' . $listener->sockport;
+
+    my $link = $class->new( address => $address );
+    $link->start_connect;
+    ok( !$link->is_connected, "not connected before finish_connect" );
+
+    my $done;
+    for ( 1 .. 10 ) {
+        select( undef, my $wout = $link->fdset, undef, 1 );
+        last if $done = $link->finish_connect;
+    }
+    ok( $done, "finish_connect completed" );
+    ok( $link->is_connected, "link is connected" );
+
+    # a port nobody listens on
+    my $port = $listener->sockport;
+    close $listener;
+    $link = $class->new( address => "127.0.0.1:$port" );
+    my $err = exception {
+        $link->start_connect;
+        for ( 1 .. 10 ) {
+            select( undef, my $wout = $link->fdset, undef, 1 );
+            last if $link->finish_connect;
+        }
+    };
+    like( $err, qr/Could not connect/, "refused connection throws error" );
+};
+
 done_testing;
 # vim: ts=4 sts=4 sw=4 et:
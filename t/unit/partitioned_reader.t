@@ -0,0 +1,233 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+use Test::Fatal;
+use File::Temp qw/tempdir/;
+
+use MongoDB;
+use MongoDB::PartitionedReader;
+
+# answers aggregate with canned $bucketAuto output and serves find from
+# canned batches, logging both
+{
+    package FakeCollection;
+    our @ISA = ('MongoDB::Collection');
+
+    sub aggregate {
+        my ( $self, $pipeline ) = @_;
+        push @{ $self->{log} }, [ aggregate => $pipeline ];
+        return FakeResult->new( [ map { [$_] } @{ $self->{buckets} } ] );
+    }
+
+    sub find {
+        my ( $self, $filter, $options ) = @_;
+        push @{ $self->{log} }, [ find => $filter, $options ];
+        return FakeResult->new( [ @{ shift @{ $self->{batches} } || [] } ] );
+    }
+
+    package FakeResult;
+    sub new    { bless { batches => $_[1] }, $_[0] }
+    sub result { $_[0] }
+    sub batch  { @{ shift @{ $_[0]{batches} } || [] } }
+    sub all    { map { @$_ } @{ $_[0]{batches} } }
+}
+
+sub _coll {
+    my (%args) = @_;
+    my $coll = MongoDB->connect->ns('db.coll');
+    return bless { %$coll, log => [], %args }, 'FakeCollection';
+}
+
+sub _buckets {
+    return [ map { { _id => { min => $_->[0], max => $_->[1] }, count => 10 } } @_ ];
+}
+
+subtest "ranges" => sub {
+    my $coll = _coll( buckets => _buckets( [ 1, 10 ], [ 10, 20 ], [ 20, 30 ] ) );
+    my $reader = MongoDB::PartitionedReader->new( collection => $coll, partitions => 3 );
+
+    is_deeply(
+        [ $reader->ranges ],
+        [
+            { _id => { '$not' => { '$gte' => 10 } } },
+            { _id => { '$gte' => 10, '$lt' => 20 } },
+            { _id => { '$gte' => 20 } },
+        ],
+        "bounds from bucket minimums"
+    );
+    is_deeply(
+        $coll->{log},
+        [
+            [
+                aggregate => [
+                    { '$sample'     => { size    => 300 } },
+                    { '$bucketAuto' => { groupBy => '$_id', buckets => 3 } },
+                ]
+            ]
+        ],
+        "sampled once"
+    );
+    $reader->ranges;
+    is( scalar @{ $coll->{log} }, 1, "ranges cached" );
+};
+
+subtest "ranges with mixed type bounds" => sub {
+    my $coll = _coll( buckets => _buckets( [ 1, 10 ], [ 10, 20 ], [ 20, 'm' ], [ 'm', 'z' ] ) );
+    my $reader = MongoDB::PartitionedReader->new( collection => $coll, partitions => 4 );
+
+    is_deeply(
+        [ $reader->ranges ],
+        [
+            { '$nor' => [ { _id => { '$gte' => 10 } }, { _id => { '$gte' => 'm' } } ] },
+            { _id => { '$gte' => 10, '$lt' => 20 } },
+            { _id => { '$gte' => 20 } },
+            { _id => { '$gte' => 'm' } },
+        ],
+        "ranges split where the type changes"
+    );
+};
+
+subtest "ranges with filter and key" => sub {
+    my $coll = _coll( buckets => _buckets( [ 'a', 'm' ], [ 'm', 'z' ] ) );
+    my $reader = MongoDB::PartitionedReader->new(
+        collection  => $coll,
+        filter      => { x => 1 },
+        key         => 'name',
+        partitions  => 2,
+        sample_size => 50,
+    );
+
+    is_deeply(
+        [ $reader->ranges ],
+        [
+            { '$and' => [ { x => 1 }, { name => { '$not' => { '$gte' => 'm' } } } ] },
+            { '$and' => [ { x => 1 }, { name => { '$gte' => 'm' } } ] },
+        ],
+        "ranges combined with filter"
+    );
+    is_deeply(
+        $coll->{log}[0][1],
+        [
+            { '$match'      => { x       => 1 } },
+            { '$sample'     => { size    => 50 } },
+            { '$bucketAuto' => { groupBy => '$name', buckets => 2 } },
+        ],
+        "filter applied before sampling"
+    );
+};
+
+subtest "single partition" => sub {
+    my $coll = _coll( buckets => _buckets( [ 1, 10 ] ) );
+    my $reader = MongoDB::PartitionedReader->new( collection => $coll, filter => { x => 1 } );
+    is_deeply( [ $reader->ranges ], [ { x => 1 } ], "empty or tiny sample reads the filter" );
+
+    $coll = _coll();
+    $reader = MongoDB::PartitionedReader->new( collection => $coll, partitions => 1 );
+    is_deeply( [ $reader->ranges ], [ {} ], "one partition" );
+    is_deeply( $coll->{log}, [], "no sample taken" );
+};
+
+subtest "next_batch" => sub {
+    my $coll = _coll(
+        buckets => _buckets( [ 1, 10 ], [ 10, 20 ] ),
+        batches => [ [ [1], [2] ], [ [11], [12], [13] ] ],
+    );
+    my $reader = MongoDB::PartitionedReader->new(
+        collection   => $coll,
+        partitions   => 2,
+        find_options => { batchSize => 5 },
+    );
+
+    my @got;
+    while ( my @batch = $reader->next_batch ) {
+        push @got, \@batch;
+    }
+    is_deeply( \@got, [ [1], [11], [2], [12], [13] ], "batches taken in turn" );
+    is_deeply(
+        [ map { $_->[2] } grep { $_->[0] eq 'find' } @{ $coll->{log} } ],
+        [ ( { batchSize => 5, prefetch => 1 } ) x 2 ],
+        "find options passed with prefetch"
+    );
+};
+
+subtest "each_partition in process" => sub {
+    my $coll = _coll(
+        buckets => _buckets( [ 1, 10 ], [ 10, 20 ] ),
+        batches => [ [ [1] ], [ [11] ] ],
+    );
+    my $reader = MongoDB::PartitionedReader->new( collection => $coll, partitions => 2 );
+
+    my @seen;
+    $reader->each_partition( sub {
+        my ( $result, $filter, $index ) = @_;
+        push @seen, [ $index, $filter, [ $result->batch ] ];
+    } );
+    is_deeply(
+        \@seen,
+        [
+            [ 0, { _id => { '$not' => { '$gte' => 10 } } }, [1] ],
+            [ 1, { _id => { '$gte' => 10 } }, [11] ],
+        ],
+        "callback per partition"
+    );
+};
+
+subtest "each_partition with workers" => sub {
+    my $reader = sub {
+        MongoDB::PartitionedReader->new(
+            collection => _coll( buckets => _buckets( [ 1, 10 ], [ 10, 20 ] ) ),
+            partitions => 2,
+            workers    => 2,
+        );
+    };
+
+    # workers report back through files
+    my $dir = tempdir( CLEANUP => 1 );
+    my $write = sub {
+        my ( $name, @lines ) = @_;
+        open my $fh, '>>', "$dir/$name" or die "$dir/$name: $!";
+        print {$fh} map { "$_\n" } @lines;
+        close $fh;
+    };
+    my $read = sub {
+        open my $fh, '<', "$dir/$_[0]" or return;
+        chomp( my @lines = <$fh> );
+        return @lines;
+    };
+
+    $reader->()->each_partition( sub { $write->( "partition-$_[2]", $$ ) } );
+    my @pids = map { $read->("partition-$_") } 0 .. 1;
+    is( scalar @pids, 2, "each partition read once" );
+    ok( !grep( { $_ == $$ } @pids ), "partitions read in workers" );
+    isnt( $pids[0], $pids[1], "one worker per partition" );
+
+    # the handler is inherited by the workers
+    local $SIG{__WARN__} = sub { $write->( 'warnings', @_ ) };
+    like(
+        exception {
+            $reader->()->each_partition( sub { die "bad partition\n" if $_[2] == 1 } )
+        },
+        qr/partition workers failed: 1\b/,
+        "failed worker reported by its exit status"
+    );
+    like( join( "\n", $read->('warnings') ),
+        qr/partition worker 1 failed: bad partition/, "worker's error warned" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
@@ -0,0 +1,158 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+
+use MongoDB::_Link;
+use Time::HiRes qw/time/;
+
+my $class = "MongoDB::_Pool";
+
+require_ok($class);
+
+# links that look connected without a socket
+{
+    package FakeLink;
+    our @ISA = ('MongoDB::_Link');
+    sub is_connected { $_[0]->connected }
+}
+
+sub _link {
+    my $link = FakeLink->new( address => 'localhost:27017' );
+    $link->_set_connected(1);
+    $link->_set_last_used(time);
+    return $link;
+}
+
+subtest "check out and check in" => sub {
+    my $pool = new_ok( $class, [ address => 'localhost:27017' ] );
+
+    ok( !defined $pool->check_out, "empty pool has nothing to check out" );
+
+    my $link = $pool->add_link( _link() );
+    is( $pool->in_use_count, 1, "added link is in use" );
+    ok( $pool->is_checked_out($link), "added link is checked out" );
+
+    ok( $pool->check_in($link), "link checked in" );
+    is( $pool->idle_count, 1, "checked in link is idle" );
+    ok( !$pool->check_in($link), "second check in is ignored" );
+
+    is( $pool->check_out, $link, "idle link is reused" );
+    is( $pool->idle_count, 0, "no idle links left" );
+};
+
+subtest "most recently used link first" => sub {
+    my $pool = new_ok( $class, [ address => 'localhost:27017' ] );
+    my @links = map { $pool->add_link( _link() ) } 1 .. 2;
+    $pool->check_in($_) for @links;
+    is( $pool->check_out, $links[1], "last checked in link is checked out" );
+};
+
+subtest "disconnected links are discarded" => sub {
+    my $pool = new_ok( $class, [ address => 'localhost:27017' ] );
+    my $link = $pool->add_link( _link() );
+    $link->_close;
+    ok( !$pool->check_in($link), "disconnected link not checked in" );
+    is( $pool->size, 0, "pool is empty" );
+};
+
+subtest "large reply buffer released" => sub {
+    my $pool = new_ok( $class, [ address => 'localhost:27017' ] );
+    my $link = $pool->add_link( _link() );
+    $link->_set_rcvbuf(16);
+
+    ${ $link->reply_buffer } = 'x' x 64;
+    $pool->check_in($link);
+    ok( defined ${ $link->reply_buffer }, "buffer within four receive buffers kept" );
+
+    $pool->check_out;
+    ${ $link->reply_buffer } = 'x' x 65;
+    $pool->check_in($link);
+    ok( !defined ${ $link->reply_buffer }, "larger buffer released at check in" );
+};
+
+subtest "max_pool_size" => sub {
+    my $pool = new_ok( $class, [ address => 'localhost:27017', max_pool_size => 2 ] );
+    $pool->add_link( _link() );
+    ok( !$pool->is_full, "pool not full" );
+    $pool->add_link( _link() );
+    ok( $pool->is_full, "pool full" );
+
+    $pool = new_ok( $class, [ address => 'localhost:27017', max_pool_size => 0 ] );
+    $pool->add_link( _link() ) for 1 .. 200;
+    ok( !$pool->is_full, "zero max_pool_size is unlimited" );
+};
+
+subtest "clear" => sub {
+    my $pool  = new_ok( $class, [ address => 'localhost:27017' ] );
+    my $idle  = $pool->add_link( _link() );
+    my $inuse = $pool->add_link( _link() );
+    $pool->check_in($idle);
+
+    $pool->clear;
+    is( $pool->generation, 1, "generation incremented" );
+    ok( !$idle->connected, "idle link closed" );
+    is( $pool->idle_count, 0, "no idle links" );
+
+    ok( !$pool->check_in($inuse), "stale link not checked in" );
+    ok( !$inuse->connected, "stale link closed on check in" );
+
+    my $fresh = $pool->add_link( _link() );
+    is( $fresh->generation, 1, "new link has current generation" );
+    ok( $pool->check_in($fresh), "new link checked in" );
+};
+
+subtest "max_idle_time_sec" => sub {
+    my $pool = new_ok( $class,
+        [ address => 'localhost:27017', max_idle_time_sec => 10, min_pool_size => 1 ] );
+    my @links = map { $pool->add_link( _link() ) } 1 .. 3;
+    $pool->check_in($_) for @links;
+    $_->_set_last_used( time - 20 ) for @links[ 0, 1 ];
+
+    is( $pool->check_out, $links[2], "fresh link checked out" );
+    is( $pool->idle_count, 0, "expired links pruned" );
+    ok( !$links[0]->connected && !$links[1]->connected, "expired links closed" );
+
+    $pool->check_in( $links[2] );
+    $links[2]->_set_last_used( time - 20 );
+    ok( !defined $pool->check_out, "expired link not checked out" );
+    is( $pool->size, 0, "expired link discarded" );
+};
+
+subtest "check_out_idle_before" => sub {
+    my $pool = new_ok( $class, [ address => 'localhost:27017' ] );
+    my @links = map { $pool->add_link( _link() ) } 1 .. 3;
+    $pool->check_in($_) for @links;
+    $links[0]->_set_last_used( time - 20 );
+    $links[1]->_set_last_used( time - 10 );
+
+    my @stale = $pool->check_out_idle_before( time - 5 );
+    is_deeply( \@stale, [ @links[ 0, 1 ] ], "links idle too long, oldest first" );
+    ok( $pool->is_checked_out($_), "stale link checked out" ) for @stale;
+    is( $pool->idle_count, 1, "recent link still idle" );
+
+    $pool = new_ok( $class, [ address => 'localhost:27017' ] );
+    @links = map { $pool->add_link( _link() ) } 1 .. 2;
+    $pool->check_in($_) for @links;
+    $_->_set_last_used( time - 20 ) for @links;
+    is_deeply( [ $pool->check_out_idle_before( time - 5, 1 ) ],
+        [ $links[0] ], "no more than the maximum, oldest first" );
+    is( $pool->idle_count, 1, "other stale link still idle" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
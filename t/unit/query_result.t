@@ -0,0 +1,228 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More;
+use Test::Fatal;
+
+use BSON;
+use MongoDB;
+use MongoDB::QueryResult;
+
+# serves getMore batches from a list and logs how each one was sent
+{
+    package FakeClient;
+    our @ISA = ('MongoDB::MongoClient');
+    sub monitoring_callback { undef }
+
+    sub _batch {
+        my ( $self, $op ) = @_;
+        my $docs = shift @{ $self->{batches} } || [];
+        return {
+            cursor_id       => @{ $self->{batches} } ? 42 : 0,
+            flags           => {},
+            starting_from   => 0,
+            number_returned => scalar @$docs,
+            docs            => $docs,
+            reply_bytes     => ( $self->{doc_bytes} || 0 ) * @$docs,
+        };
+    }
+
+    sub send_direct_op {
+        my ( $self, $op ) = @_;
+        push @{ $self->{log} }, [ send => $op->batch_size ];
+        return $self->_batch($op);
+    }
+
+    sub start_direct_op {
+        my ( $self, $op ) = @_;
+        return if $self->{legacy};
+        die "start failed\n" if $self->{fail_start};
+        push @{ $self->{log} }, [ start => $op->batch_size ];
+        return 'link';
+    }
+
+    sub finish_direct_op {
+        my ( $self, $op, $link ) = @_;
+        push @{ $self->{log} }, ['finish'];
+        return $self->_batch($op);
+    }
+
+    sub abandon_direct_op {
+        my ( $self, $op, $link ) = @_;
+        push @{ $self->{log} }, ['abandon'];
+        return;
+    }
+
+    sub _defer_kill_cursors {
+        my ( $self, $address, $op ) = @_;
+        push @{ $self->{log} }, [ defer => @{ $op->cursor_ids } ];
+        return;
+    }
+}
+
+sub _client {
+    my $client = bless { batches => [@_], log => [] }, 'FakeClient';
+    return $client;
+}
+
+sub _iterate {
+    my ($result) = @_;
+    my @got;
+    while ( defined( my $doc = $result->next ) ) {
+        push @got, $doc;
+    }
+    return \@got;
+}
+
+sub _result {
+    my ( $client, %args ) = @_;
+    my $first = delete $args{first};
+    return MongoDB::QueryResult->_new(
+        _client       => $client,
+        _address      => 'localhost:27017',
+        _full_name    => 'db.coll',
+        _bson_codec   => BSON->new,
+        _batch_size   => 3,
+        _cursor_at    => 0,
+        _limit        => 0,
+        _cursor_id    => 42,
+        _cursor_start => 0,
+        _cursor_flags => {},
+        _cursor_num   => scalar @$first,
+        _docs         => $first,
+        %args,
+    );
+}
+
+subtest "next sends getMore ahead" => sub {
+    my $client = _client( [ 4 .. 6 ], [7] );
+    my $result = _result( $client, first => [ 1 .. 3 ], _prefetch => 1 );
+
+    my @got;
+    while ( my $doc = $result->next ) {
+        push @got, $doc;
+        push @{ $client->{log} }, [ got => $doc ];
+    }
+
+    is_deeply( \@got, [ 1 .. 7 ], "all documents in order" );
+    is_deeply(
+        $client->{log},
+        [
+            [ got => 1 ],
+            [ start => 3 ], [ got => 2 ], [ got => 3 ],
+            ['finish'], [ got => 4 ],
+            [ start => 3 ], [ got => 5 ], [ got => 6 ],
+            ['finish'], [ got => 7 ],
+        ],
+        "getMore sent below the threshold and collected when drained"
+    );
+};
+
+subtest "batch sends getMore ahead" => sub {
+    my $client = _client( [ 4 .. 6 ] );
+    my $result = _result( $client, first => [ 1 .. 3 ], _prefetch => 1 );
+
+    is_deeply( [ $result->batch ], [ 1 .. 3 ], "first batch" );
+    is_deeply( $client->{log}, [ [ start => 3 ] ], "next batch requested" );
+    is_deeply( [ $result->batch ], [ 4 .. 6 ], "second batch" );
+    ok( !$result->has_next, "exhausted" );
+    is_deeply( $client->{log}, [ [ start => 3 ], ['finish'] ], "no getMore after the last batch" );
+};
+
+subtest "failed prefetch" => sub {
+    my $client = _client( [ 4 .. 6 ] );
+    $client->{fail_start} = 1;
+    my $result = _result( $client, first => [ 1 .. 3 ], _prefetch => 1 );
+    is_deeply( [ $result->batch ], [ 1 .. 3 ], "batch returned despite the error" );
+    is( exception { $result->batch }, "start failed\n", "error thrown by the next getMore" );
+
+    $result = _result( $client, first => [ 1 .. 3 ], _prefetch => 1 );
+    is_deeply( [ map { $result->next } 1 .. 3 ], [ 1 .. 3 ], "documents returned despite the error" );
+    is( exception { $result->next }, "start failed\n", "error thrown once drained" );
+};
+
+subtest "destroyed during a prefetch" => sub {
+    my $client = _client( [ 4 .. 6 ], [7] );
+    my $result = _result( $client, first => [ 1 .. 3 ], _prefetch => 1 );
+    $result->next for 1 .. 2;
+    undef $result;
+    is_deeply( $client->{log}, [ [ start => 3 ], ['abandon'] ], "reply left to drain, not waited for" );
+
+    $client = _client( [ 4 .. 6 ], [7] );
+    $result = _result( $client, first => [ 1 .. 3 ] );
+    undef $result;
+    is_deeply( $client->{log}, [ [ defer => 42 ] ], "kill deferred without a prefetch" );
+};
+
+subtest "limit" => sub {
+    my $client = _client( [ 3 .. 4 ] );
+    my $result = _result( $client, first => [ 1 .. 2 ], _prefetch => 2, _limit => 4 );
+
+    is( $result->next, 1, "first document" );
+    is_deeply( $client->{log}, [ [ start => 2 ] ], "getMore asks for the rest of the limit" );
+    is_deeply( [ $result->all ], [ 2 .. 4 ], "rest of the documents" );
+};
+
+subtest "no prefetch without a split getMore" => sub {
+    my $client = _client( [ 4 .. 6 ] );
+    $client->{legacy} = 1;
+    my $result = _result( $client, first => [ 1 .. 3 ], _prefetch => 1 );
+
+    is_deeply( _iterate($result), [ 1 .. 6 ], "all documents" );
+    is_deeply( $client->{log}, [ [ send => 3 ] ], "getMore sent when drained" );
+};
+
+subtest "off by default" => sub {
+    my $client = _client( [ 4 .. 6 ] );
+    my $result = _result( $client, first => [ 1 .. 3 ] );
+
+    is_deeply( _iterate($result), [ 1 .. 6 ], "all documents" );
+    is_deeply( $client->{log}, [ [ send => 3 ] ], "getMore sent when drained" );
+};
+
+subtest "adaptive batch size" => sub {
+    my $client = _client( [ 4 .. 6 ], [7] );
+    $client->{doc_bytes} = 500;
+    my $result = _result(
+        $client,
+        first               => [ 1 .. 3 ],
+        _reply_bytes        => 300,
+        _target_batch_bytes => 1000,
+        _max_batch_bytes    => 1000,
+    );
+
+    is_deeply( _iterate($result), [ 1 .. 7 ], "all documents" );
+    is_deeply(
+        $client->{log},
+        [ [ send => 10 ], [ send => 2 ] ],
+        "sized from the first reply, then capped by the largest documents"
+    );
+
+    $client = _client( [ 4 .. 6 ] );
+    $result = _result(
+        $client,
+        first               => [ 1 .. 3 ],
+        _reply_bytes        => 300,
+        _target_batch_bytes => 1000,
+        _limit              => 5,
+    );
+    is_deeply( _iterate($result), [ 1 .. 5 ], "documents up to the limit" );
+    is_deeply( $client->{log}, [ [ send => 2 ] ], "limit bounds the batch size" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et:
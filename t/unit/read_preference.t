@@ -16,6 +16,7 @@ use strict;
 use warnings;
 use Test::More 0.88;
 use Test::Fatal;
+use boolean;
 
 my $class = "MongoDB::ReadPreference";
 
@@ -64,6 +65,29 @@ subtest "max_staleness_seconds" => sub {
     );
 };
 
+subtest "hedge" => sub {
+    my $rp = new_ok( $class, [ mode => 'nearest', hedge => { enabled => 1 } ] );
+    ok( $rp->is_hedged, "is_hedged" );
+    ok( !exists $rp->_as_hashref->{hedge}, "not sent to mongod" );
+    is_deeply(
+        $rp->_as_mongos_hashref,
+        { mode => 'nearest', hedge => { enabled => true } },
+        "sent to mongos"
+    );
+
+    $rp = $class->new( mode => 'nearest', hedge => { enabled => 0 } );
+    ok( !$rp->is_hedged, "disabled" );
+    is_deeply( $rp->_as_mongos_hashref->{hedge}, { enabled => false }, "disabled for mongos" );
+
+    ok( !$class->new( mode => 'nearest' )->is_hedged, "off by default" );
+
+    like(
+        exception { $class->new( mode => 'primary', hedge => { enabled => 1 } ) },
+        qr/not allowed/,
+        "hedge not allowed with primary"
+    );
+};
+
 subtest "stringification" => sub {
     my $rp;
 
@@ -0,0 +1,134 @@
+#  Copyright 2020 - present MongoDB, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+use strict;
+use warnings;
+use Test::More 0.88;
+
+use BSON;
+use MongoDB;
+use MongoDB::Op::_Command;
+use MongoDB::Op::_InsertOne;
+
+use lib "t/lib";
+use MongoDBTest::FakeLink qw/fake_link read_request/;
+
+my $codec = BSON->new;
+
+# the flag bits and command document of an OP_MSG request
+sub _parse_msg {
+    my ($msg) = @_;
+    my ( undef, $request_id, undef, $opcode, $flags ) = unpack( 'l<4 V', $msg );
+    is( $opcode, 2013, "sent as OP_MSG" );
+    my $doc_len = unpack( 'l<', substr( $msg, 21, 4 ) );
+    return ( $request_id, $flags, $codec->decode_one( substr( $msg, 21, $doc_len ) ) );
+}
+
+sub _reply {
+    my ( $id, $response_to, $doc ) = @_;
+    my $body = "\0" . $codec->encode_one($doc);
+    return pack( 'l<5', 20 + length $body, $id, $response_to, 2013, 0 ) . $body;
+}
+
+sub _command {
+    my ( $query, %args ) = @_;
+    return MongoDB::Op::_Command->_new(
+        db_name             => 'db',
+        query               => $query,
+        query_flags         => {},
+        bson_codec          => $codec,
+        monitoring_callback => undef,
+        %args,
+    );
+}
+
+# an op that waits for a reply the server never sends times out quickly
+# instead of hanging the test
+sub _link_and_server { fake_link( socket_timeout => 0.5 ) }
+
+subtest "w:0 insert over OP_MSG" => sub {
+    my $client  = MongoDB->connect('mongodb://localhost');
+    my $coll    = $client->ns('db.coll')->clone( write_concern => { w => 0 } );
+    my $session = $client->_start_client_session(1);
+    my ( $link, $server ) = _link_and_server();
+
+    my $op = MongoDB::Op::_InsertOne->_new(
+        session  => $session,
+        document => { x => 1 },
+        %{ $coll->_op_args },
+    );
+    isa_ok( $op->execute($link), 'MongoDB::UnacknowledgedResult', "result" );
+
+    my ( undef, $flags, $doc ) = _parse_msg( read_request($server) );
+    ok( $flags & 2, "moreToCome set" );
+    is( $doc->{insert}, 'coll', "insert command" );
+    ok( !exists $doc->{lsid}, "no session" );
+};
+
+subtest "unacknowledged command" => sub {
+    my $client  = MongoDB->connect('mongodb://localhost');
+    my $session = $client->_start_client_session(1);
+    my ( $link, $server ) = _link_and_server();
+
+    my $op = _command(
+        [ insert => 'coll', documents => [ { x => 1 } ], writeConcern => { w => 0 } ],
+        session        => $session,
+        unacknowledged => 1,
+    );
+    my $res = $op->execute($link);
+    isa_ok( $res, 'MongoDB::CommandResult', "result" );
+    is( $res->output->{ok}, 1, "reported as ok" );
+
+    my ( undef, $flags, $doc ) = _parse_msg( read_request($server) );
+    ok( $flags & 2, "moreToCome set" );
+    ok( !exists $doc->{lsid}, "no session" );
+};
+
+subtest "pipelined with an unacknowledged command" => sub {
+    my ( $link, $server ) = _link_and_server();
+    my @ops = (
+        _command(
+            [ insert => 'coll', documents => [ { x => 1 } ], writeConcern => { w => 0 } ],
+            unacknowledged => 1,
+        ),
+        _command( [ ping => 1 ] ),
+    );
+
+    # answers once both commands are written, before the replies are read
+    my ( @requests, $waited_for );
+    my $read_replies = \&MongoDB::_Link::read_replies;
+    no warnings 'redefine';
+    local *MongoDB::_Link::read_replies = sub {
+        my ( $self, $request_ids ) = @_;
+        $waited_for = [@$request_ids];
+        @requests = map { [ _parse_msg( read_request($server) ) ] } 1 .. 2;
+        syswrite( $server, _reply( 101, $requests[1][0], { ok => 1, pong => 1 } ) );
+        return $read_replies->(@_);
+    };
+
+    my @results = MongoDB::Op::_Command->execute_pipelined( $link, \@ops );
+
+    ok( $requests[0][1] & 2,     "moreToCome set on the unacknowledged command" );
+    ok( !( $requests[1][1] & 2 ), "moreToCome not set on the acknowledged one" );
+    is_deeply( $waited_for, [ $requests[1][0] ], "only the acknowledged reply read" );
+
+    is( scalar @results, 2, "a result for each command" );
+    isa_ok( $results[0], 'MongoDB::CommandResult', "unacknowledged result" );
+    is( $results[0]->output->{ok}, 1, "unacknowledged command reported as ok" );
+    is( $results[1]->output->{pong}, 1, "reply matched to the acknowledged command" );
+};
+
+done_testing;
+
+# vim: ts=4 sts=4 sw=4 et: